@@ -341,6 +341,36 @@ uint32_t Adafruit_BME280::read24(byte reg) {
   return value;
 }
 
+/*!
+ *   @brief  Reads consecutive registers in a single I2C or SPI transaction
+ *   @param reg the first register address to read from
+ *   @param buffer destination for the data bytes
+ *   @param len the number of bytes to read
+ */
+void Adafruit_BME280::readBurst(byte reg, uint8_t *buffer, uint8_t len) {
+  if (_cs == -1) {
+    _wire->beginTransmission((uint8_t)_i2caddr);
+    _wire->write((uint8_t)reg);
+    _wire->endTransmission();
+    _wire->requestFrom((uint8_t)_i2caddr, (byte)len);
+
+    for (uint8_t i = 0; i < len; i++)
+      buffer[i] = _wire->read();
+  } else {
+    if (_sck == -1)
+      _spi->beginTransaction(SPISettings(500000, MSBFIRST, SPI_MODE0));
+    digitalWrite(_cs, LOW);
+    spixfer(reg | 0x80); // read, bit 7 high
+
+    for (uint8_t i = 0; i < len; i++)
+      buffer[i] = spixfer(0);
+
+    digitalWrite(_cs, HIGH);
+    if (_sck == -1)
+      _spi->endTransaction(); // release the SPI bus
+  }
+}
+
 /*!
  *  @brief  Take a new measurement (only possible in forced mode)
     @returns true in case of success else false
@@ -414,12 +444,160 @@ bool Adafruit_BME280::isReadingCalibration(void) {
  *   @returns the temperature read from the device
  */
 float Adafruit_BME280::readTemperature(void) {
-  int32_t var1, var2;
-
   int32_t adc_T = read24(BME280_REGISTER_TEMPDATA);
   if (adc_T == 0x800000) // value in case temp measurement was disabled
     return NAN;
+
+  return compensateTemperature(adc_T >> 4);
+}
+
+/*!
+ *   @brief  Returns the pressure from the sensor
+ *   @returns the pressure value (in Pascal) read from the device
+ */
+float Adafruit_BME280::readPressure(void) {
+  readTemperature(); // must be done first to get t_fine
+
+  int32_t adc_P = read24(BME280_REGISTER_PRESSUREDATA);
+  if (adc_P == 0x800000) // value in case pressure measurement was disabled
+    return NAN;
+
+  return compensatePressure(adc_P >> 4);
+}
+
+/*!
+ *  @brief  Returns the humidity from the sensor
+ *  @returns the humidity value read from the device
+ */
+float Adafruit_BME280::readHumidity(void) {
+  readTemperature(); // must be done first to get t_fine
+
+  int32_t adc_H = read16(BME280_REGISTER_HUMIDDATA);
+  if (adc_H == 0x8000) // value in case humidity measurement was disabled
+    return NAN;
+
+  return compensateHumidity(adc_H);
+}
+
+/*!
+ *  @brief  Returns temperature, pressure and humidity of the same measurement
+ *
+ *  All data registers (0xF7 - 0xFE) are read in a single burst and
+ *  temperature is compensated only once, instead of once per value as with
+ *  separate readTemperature(), readPressure() and readHumidity() calls.
+ *  @returns the measurement, disabled values are NAN
+ */
+bme280_measurement Adafruit_BME280::readAll(void) {
+  bme280_measurement measurement;
+  int32_t adc_T, adc_P, adc_H;
+
+  if (!readAdc(adc_T, adc_P, adc_H)) {
+    measurement.temperature = measurement.pressure = measurement.humidity = NAN;
+    return measurement;
+  }
+  measurement.temperature = compensateTemperature(adc_T);
+  measurement.pressure = (adc_P < 0) ? NAN : compensatePressure(adc_P);
+  measurement.humidity = (adc_H < 0) ? NAN : compensateHumidity(adc_H);
+
+  return measurement;
+}
+
+/*!
+ *  @brief  Returns temperature, pressure and humidity of the same measurement
+ *          in fixed point
+ *
+ *  Same as readAll(), but only the integer compensation formulas of the
+ *  datasheet are used, no floating point operation is performed.
+ *  @returns the measurement, disabled values are BME280_FIXED_DISABLED
+ */
+bme280_fixed_measurement Adafruit_BME280::readAllFixed(void) {
+  bme280_fixed_measurement measurement;
+  int32_t adc_T, adc_P, adc_H;
+
+  if (!readAdc(adc_T, adc_P, adc_H)) {
+    measurement.temperature = measurement.pressure = measurement.humidity =
+        BME280_FIXED_DISABLED;
+    return measurement;
+  }
+  measurement.temperature = compensateTemperatureFixed(adc_T);
+
+  // Q24.8 Pa, rounded to Pa
+  measurement.pressure = (adc_P < 0)
+                             ? BME280_FIXED_DISABLED
+                             : (compensatePressureFixed(adc_P) + 128) >> 8;
+
+  // Q22.10 %, rounded to 0.01 %
+  measurement.humidity =
+      (adc_H < 0) ? BME280_FIXED_DISABLED
+                  : (compensateHumidityFixed(adc_H) * 100 + 512) >> 10;
+
+  return measurement;
+}
+
+/*!
+ *  @brief  Reads all data registers (0xF7 - 0xFE) in a single burst and
+ *          unpacks the raw values, shared by readAll() and readAllFixed()
+ *  @param adc_T set to the 20 bit raw temperature value
+ *  @param adc_P set to the 20 bit raw pressure value, -1 if disabled
+ *  @param adc_H set to the 16 bit raw humidity value, -1 if disabled
+ *  @returns false if the temperature measurement is disabled, pressure and
+ *           humidity can't be compensated without t_fine then
+ */
+bool Adafruit_BME280::readAdc(int32_t &adc_T, int32_t &adc_P,
+                              int32_t &adc_H) {
+  uint8_t data[8];
+
+  readBurst(BME280_REGISTER_PRESSUREDATA, data, sizeof(data));
+
+  adc_P = ((uint32_t)data[0] << 16) | ((uint32_t)data[1] << 8) | data[2];
+  adc_T = ((uint32_t)data[3] << 16) | ((uint32_t)data[4] << 8) | data[5];
+  adc_H = ((uint32_t)data[6] << 8) | data[7];
+
+  // values in case a measurement was disabled
+  adc_P = (adc_P == 0x800000) ? -1 : adc_P >> 4;
+  adc_H = (adc_H == 0x8000) ? -1 : adc_H;
+  if (adc_T == 0x800000)
+    return false;
   adc_T >>= 4;
+  return true;
+}
+
+/*!
+ *   @brief  Compensates a raw temperature value and updates t_fine
+ *   @param adc_T the 20 bit raw temperature value
+ *   @returns the temperature in degrees Celsius
+ */
+float Adafruit_BME280::compensateTemperature(int32_t adc_T) {
+  float T = compensateTemperatureFixed(adc_T);
+  return T / 100;
+}
+
+/*!
+ *   @brief  Compensates a raw pressure value, t_fine has to be up to date
+ *   @param adc_P the 20 bit raw pressure value
+ *   @returns the pressure in Pascal
+ */
+float Adafruit_BME280::compensatePressure(int32_t adc_P) {
+  return (float)compensatePressureFixed(adc_P) / 256;
+}
+
+/*!
+ *   @brief  Compensates a raw humidity value, t_fine has to be up to date
+ *   @param adc_H the 16 bit raw humidity value
+ *   @returns the relative humidity in %
+ */
+float Adafruit_BME280::compensateHumidity(int32_t adc_H) {
+  float h = compensateHumidityFixed(adc_H);
+  return h / 1024.0;
+}
+
+/*!
+ *   @brief  Compensates a raw temperature value and updates t_fine
+ *   @param adc_T the 20 bit raw temperature value
+ *   @returns the temperature in 0.01 degrees Celsius
+ */
+int32_t Adafruit_BME280::compensateTemperatureFixed(int32_t adc_T) {
+  int32_t var1, var2;
 
   var1 = ((((adc_T >> 3) - ((int32_t)_bme280_calib.dig_T1 << 1))) *
           ((int32_t)_bme280_calib.dig_T2)) >>
@@ -433,24 +611,17 @@ float Adafruit_BME280::readTemperature(void) {
 
   t_fine = var1 + var2 + t_fine_adjust;
 
-  float T = (t_fine * 5 + 128) >> 8;
-  return T / 100;
+  return (t_fine * 5 + 128) >> 8;
 }
 
 /*!
- *   @brief  Returns the pressure from the sensor
- *   @returns the pressure value (in Pascal) read from the device
+ *   @brief  Compensates a raw pressure value, t_fine has to be up to date
+ *   @param adc_P the 20 bit raw pressure value
+ *   @returns the pressure in Pascal as unsigned Q24.8
  */
-float Adafruit_BME280::readPressure(void) {
+uint32_t Adafruit_BME280::compensatePressureFixed(int32_t adc_P) {
   int64_t var1, var2, p;
 
-  readTemperature(); // must be done first to get t_fine
-
-  int32_t adc_P = read24(BME280_REGISTER_PRESSUREDATA);
-  if (adc_P == 0x800000) // value in case pressure measurement was disabled
-    return NAN;
-  adc_P >>= 4;
-
   var1 = ((int64_t)t_fine) - 128000;
   var2 = var1 * var1 * (int64_t)_bme280_calib.dig_P6;
   var2 = var2 + ((var1 * (int64_t)_bme280_calib.dig_P5) << 17);
@@ -469,20 +640,15 @@ float Adafruit_BME280::readPressure(void) {
   var2 = (((int64_t)_bme280_calib.dig_P8) * p) >> 19;
 
   p = ((p + var1 + var2) >> 8) + (((int64_t)_bme280_calib.dig_P7) << 4);
-  return (float)p / 256;
+  return (uint32_t)p;
 }
 
 /*!
- *  @brief  Returns the humidity from the sensor
- *  @returns the humidity value read from the device
+ *   @brief  Compensates a raw humidity value, t_fine has to be up to date
+ *   @param adc_H the 16 bit raw humidity value
+ *   @returns the relative humidity in % as unsigned Q22.10
  */
-float Adafruit_BME280::readHumidity(void) {
-  readTemperature(); // must be done first to get t_fine
-
-  int32_t adc_H = read16(BME280_REGISTER_HUMIDDATA);
-  if (adc_H == 0x8000) // value in case humidity measurement was disabled
-    return NAN;
-
+uint32_t Adafruit_BME280::compensateHumidityFixed(int32_t adc_H) {
   int32_t v_x1_u32r;
 
   v_x1_u32r = (t_fine - ((int32_t)76800));
@@ -506,8 +672,7 @@ float Adafruit_BME280::readHumidity(void) {
 
   v_x1_u32r = (v_x1_u32r < 0) ? 0 : v_x1_u32r;
   v_x1_u32r = (v_x1_u32r > 419430400) ? 419430400 : v_x1_u32r;
-  float h = (v_x1_u32r >> 12);
-  return h / 1024.0;
+  return (uint32_t)(v_x1_u32r >> 12);
 }
 
 /*!
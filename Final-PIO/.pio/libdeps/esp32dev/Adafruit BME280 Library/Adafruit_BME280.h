@@ -105,6 +105,32 @@ typedef struct {
 } bme280_calib_data;
 /*=========================================================================*/
 
+/**************************************************************************/
+/*!
+    @brief  all values of a single measurement, see readAll()
+*/
+/**************************************************************************/
+typedef struct {
+  float temperature; ///< temperature in degrees Celsius
+  float pressure;    ///< pressure in Pascal
+  float humidity;    ///< relative humidity in %
+} bme280_measurement;
+
+/** value of a disabled measurement in bme280_fixed_measurement */
+#define BME280_FIXED_DISABLED INT32_MIN
+
+/**************************************************************************/
+/*!
+    @brief  all values of a single measurement in fixed point, see
+   readAllFixed()
+*/
+/**************************************************************************/
+typedef struct {
+  int32_t temperature; ///< temperature in 0.01 degrees Celsius
+  int32_t pressure;    ///< pressure in Pascal
+  int32_t humidity;    ///< relative humidity in 0.01 %
+} bme280_fixed_measurement;
+
 class Adafruit_BME280;
 
 /** Adafruit Unified Sensor interface for temperature component of BME280 */
@@ -229,6 +255,8 @@ public:
   float readTemperature(void);
   float readPressure(void);
   float readHumidity(void);
+  bme280_measurement readAll(void);
+  bme280_fixed_measurement readAllFixed(void);
 
   float readAltitude(float seaLevel);
   float seaLevelForAltitude(float altitude, float pressure);
@@ -265,6 +293,16 @@ protected:
   int16_t readS16(byte reg);
   uint16_t read16_LE(byte reg); // little endian
   int16_t readS16_LE(byte reg); // little endian
+  void readBurst(byte reg, uint8_t *buffer, uint8_t len);
+  bool readAdc(int32_t &adc_T, int32_t &adc_P, int32_t &adc_H);
+
+  float compensateTemperature(int32_t adc_T);
+  float compensatePressure(int32_t adc_P);
+  float compensateHumidity(int32_t adc_H);
+
+  int32_t compensateTemperatureFixed(int32_t adc_T);
+  uint32_t compensatePressureFixed(int32_t adc_P);
+  uint32_t compensateHumidityFixed(int32_t adc_H);
 
   uint8_t _i2caddr;  //!< I2C addr for the TwoWire interface
   int32_t _sensorID; //!< ID of the BME Sensor
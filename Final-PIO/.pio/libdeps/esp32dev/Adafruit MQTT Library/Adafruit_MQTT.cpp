@@ -135,6 +135,8 @@ Adafruit_MQTT::Adafruit_MQTT(const char *server, uint16_t port, const char *cid,
   keepAliveInterval = MQTT_CONN_KEEPALIVE;
 
   packet_id_counter = 0;
+
+  discardInflight();
 }
 
 Adafruit_MQTT::Adafruit_MQTT(const char *server, uint16_t port,
@@ -158,6 +160,8 @@ Adafruit_MQTT::Adafruit_MQTT(const char *server, uint16_t port,
   keepAliveInterval = MQTT_CONN_KEEPALIVE;
 
   packet_id_counter = 0;
+
+  discardInflight();
 }
 
 int8_t Adafruit_MQTT::connect() {
@@ -213,6 +217,10 @@ int8_t Adafruit_MQTT::connect() {
       return -2; // failed to sub for some reason
   }
 
+  // Publishes still in flight may have been lost with the old connection.
+  if (!retransmitInflight(true))
+    return -1;
+
   return 0;
 }
 
@@ -372,6 +380,166 @@ bool Adafruit_MQTT::publish(const char *topic, uint8_t *data, uint16_t bLen,
   return true;
 }
 
+bool Adafruit_MQTT::publishPipelined(const char *topic, uint8_t *data,
+                                     uint16_t bLen) {
+  InflightPublish *slot = NULL;
+  uint32_t start = millis();
+  while (true) {
+    for (uint8_t i = 0; i < MQTT_INFLIGHT_WINDOW && !slot; i++) {
+      if (inflightPublishes[i].packetid == 0)
+        slot = &inflightPublishes[i];
+    }
+    if (slot)
+      break;
+    // Window full, wait for a PUBACK.
+    uint32_t elapsed = millis() - start;
+    if (elapsed >= PUBLISH_TIMEOUT_MS || !connected())
+      return false;
+    processPubacks(PUBLISH_TIMEOUT_MS - elapsed);
+  }
+
+  reservePacketId();
+  uint16_t packetid = packet_id_counter;
+  uint16_t len = publishPacket(slot->packet, topic, data, bLen, MQTT_QOS_1,
+                               (uint16_t)sizeof(slot->packet));
+  if (!sendPacket(slot->packet, len))
+    return false;
+
+  slot->packetid = packetid;
+  slot->len = len;
+  slot->sent = millis();
+  return true;
+}
+
+bool Adafruit_MQTT::publishDirect(const char *topic, const uint8_t *data,
+                                  uint16_t bLen, uint8_t qos) {
+  if (qos > 0)
+    reservePacketId();
+  uint16_t packetid = packet_id_counter;
+
+  // Only the header goes through the packet buffer, the payload is written
+  // straight from the caller's memory.
+  uint16_t len = publishHeader(buffer, topic, bLen, qos);
+  if (len == 0)
+    return false;
+  if (!sendPacket(buffer, len) || !sendPacket((uint8_t *)data, bLen))
+    return false;
+
+  if (qos == 0)
+    return true;
+
+  // Wait for the matching PUBACK, other packets (f.e. PUBACKs of pipelined
+  // publishes) are processed meanwhile.
+  uint32_t start = millis();
+  while (true) {
+    uint32_t elapsed = millis() - start;
+    if (elapsed >= PUBLISH_TIMEOUT_MS)
+      return false;
+    len = readFullPacket(buffer, MAXBUFFERSIZE, PUBLISH_TIMEOUT_MS - elapsed);
+    if (len == 0)
+      return false;
+    if ((buffer[0] >> 4) == MQTT_CTRL_PUBACK && len == 4 &&
+        (((uint16_t)buffer[2] << 8) | buffer[3]) == packetid)
+      return true;
+    handlePacket(len);
+  }
+}
+
+bool Adafruit_MQTT::flushPipelined(uint16_t timeout) {
+  uint32_t start = millis();
+  while (inflight() > 0) {
+    uint32_t elapsed = millis() - start;
+    if (elapsed >= timeout || !connected())
+      return false;
+    if (!retransmitInflight(false))
+      return false;
+    // Wake up regularly to retransmit overdue publishes.
+    uint32_t wait = timeout - elapsed;
+    if (wait > MQTT_RETRANSMIT_MS / 4)
+      wait = MQTT_RETRANSMIT_MS / 4;
+    processPubacks(wait);
+  }
+  return true;
+}
+
+uint8_t Adafruit_MQTT::inflight() {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < MQTT_INFLIGHT_WINDOW; i++) {
+    if (inflightPublishes[i].packetid != 0)
+      count++;
+  }
+  return count;
+}
+
+void Adafruit_MQTT::poll() {
+  while (processPubacks(0))
+    ;
+}
+
+void Adafruit_MQTT::discardInflight() {
+  for (uint8_t i = 0; i < MQTT_INFLIGHT_WINDOW; i++) {
+    inflightPublishes[i].packetid = 0;
+  }
+}
+
+void Adafruit_MQTT::reservePacketId() {
+  // 0 is not a valid packet id, and an id must not be reused while in flight.
+  bool used;
+  do {
+    if (packet_id_counter == 0)
+      packet_id_counter++;
+    used = false;
+    for (uint8_t i = 0; i < MQTT_INFLIGHT_WINDOW; i++) {
+      if (inflightPublishes[i].packetid == packet_id_counter)
+        used = true;
+    }
+    if (used)
+      packet_id_counter++;
+  } while (used);
+}
+
+bool Adafruit_MQTT::processPubacks(uint16_t timeout) {
+  uint16_t len = readFullPacket(buffer, MAXBUFFERSIZE, timeout);
+  if (len == 0)
+    return false;
+  handlePacket(len);
+  return true;
+}
+
+void Adafruit_MQTT::handlePacket(uint16_t len) {
+  uint8_t packetType = (buffer[0] >> 4);
+  if (packetType == MQTT_CTRL_PUBLISH) {
+    handleSubscriptionPacket(len);
+  } else if (packetType == MQTT_CTRL_PUBACK && len == 4) {
+    uint16_t packetid = ((uint16_t)buffer[2] << 8) | buffer[3];
+    for (uint8_t i = 0; i < MQTT_INFLIGHT_WINDOW; i++) {
+      if (inflightPublishes[i].packetid == packetid) {
+        inflightPublishes[i].packetid = 0;
+        DEBUG_PRINT(F("PUBACK for packet "));
+        DEBUG_PRINTLN(packetid);
+      }
+    }
+  } else {
+    ERROR_PRINTLN(F("Dropped a packet"));
+  }
+}
+
+bool Adafruit_MQTT::retransmitInflight(bool all) {
+  uint32_t now = millis();
+  for (uint8_t i = 0; i < MQTT_INFLIGHT_WINDOW; i++) {
+    InflightPublish &publish = inflightPublishes[i];
+    if (publish.packetid == 0)
+      continue;
+    if (!all && now - publish.sent < MQTT_RETRANSMIT_MS)
+      continue;
+    publish.packet[0] |= 0x08; // DUP flag
+    if (!sendPacket(publish.packet, publish.len))
+      return false;
+    publish.sent = now;
+  }
+  return true;
+}
+
 bool Adafruit_MQTT::will(const char *topic, const char *payload, uint8_t qos,
                          uint8_t retain) {
 
@@ -779,6 +947,39 @@ uint16_t Adafruit_MQTT::publishPacket(uint8_t *packet, const char *topic,
   return len;
 }
 
+// Everything of a publish packet up to the payload. Returns 0 if the topic
+// doesn't fit into the packet.
+uint16_t Adafruit_MQTT::publishHeader(uint8_t *packet, const char *topic,
+                                      uint16_t bLen, uint8_t qos) {
+  uint16_t topiclen = strlen(topic);
+  uint32_t len = 2 + topiclen + (qos > 0 ? 2 : 0);
+  if (1 + 4 + len > MAXBUFFERSIZE)
+    return 0;
+  len += bLen;
+
+  uint8_t *p = packet;
+  p[0] = MQTT_CTRL_PUBLISH << 4 | qos << 1;
+  p++;
+  do {
+    uint8_t encodedByte = len % 128;
+    len /= 128;
+    if (len > 0) {
+      encodedByte |= 0x80;
+    }
+    p[0] = encodedByte;
+    p++;
+  } while (len > 0);
+
+  p = stringprint(p, topic);
+  if (qos > 0) {
+    p[0] = (packet_id_counter >> 8) & 0xFF;
+    p[1] = packet_id_counter & 0xFF;
+    p += 2;
+    packet_id_counter++;
+  }
+  return p - packet;
+}
+
 uint8_t Adafruit_MQTT::subscribePacket(uint8_t *packet, const char *topic,
                                        uint8_t qos) {
   uint8_t *p = packet;
@@ -937,3 +1138,65 @@ void Adafruit_MQTT_Subscribe::removeCallback(void) {
   callback_io = 0;
   io_mqtt = 0;
 }
+
+// Adafruit_MQTT_PacketDecoder Definition ////////////////////////////////////
+
+Adafruit_MQTT_PacketDecoder::Adafruit_MQTT_PacketDecoder(uint8_t *buffer,
+                                                         uint16_t maxsize)
+    : buffer(buffer), maxsize(maxsize) {
+  reset();
+}
+
+void Adafruit_MQTT_PacketDecoder::reset() {
+  len = 0;
+  remaining = 0;
+  multiplier = 1;
+  state = TYPE;
+}
+
+uint32_t Adafruit_MQTT_PacketDecoder::needed() const {
+  switch (state) {
+  case PAYLOAD:
+    return remaining;
+  case COMPLETE:
+    return 0;
+  default:
+    return 1;
+  }
+}
+
+uint16_t Adafruit_MQTT_PacketDecoder::feed(const uint8_t *data, uint16_t n) {
+  uint16_t used = 0;
+  while (used < n && state != COMPLETE) {
+    uint8_t c = data[used++];
+    if (len < maxsize)
+      buffer[len++] = c;
+
+    switch (state) {
+    case TYPE:
+      state = LENGTH;
+      break;
+    case LENGTH:
+      remaining += (uint32_t)(c & 0x7F) * multiplier;
+      multiplier *= 128;
+      if (c & 0x80) {
+        if (multiplier > (128UL * 128UL * 128UL)) {
+          DEBUG_PRINT(F("Malformed packet len\n"));
+          reset();
+        }
+        break;
+      }
+      DEBUG_PRINT(F("Packet Length:\t"));
+      DEBUG_PRINTLN(remaining);
+      state = remaining ? PAYLOAD : COMPLETE;
+      break;
+    case PAYLOAD:
+      if (--remaining == 0)
+        state = COMPLETE;
+      break;
+    default:
+      break;
+    }
+  }
+  return used;
+}
@@ -101,6 +101,10 @@
 #define PING_TIMEOUT_MS 500
 #define SUBACK_TIMEOUT_MS 500
 
+// Resend a pipelined QoS 1 publish (with the DUP flag) if its PUBACK hasn't
+// arrived after this many milliseconds.
+#define MQTT_RETRANSMIT_MS 2000
+
 // Adjust as necessary, in seconds.  Default to 5 minutes.
 #define MQTT_CONN_KEEPALIVE 300
 
@@ -127,6 +131,17 @@
 #define SUBSCRIPTIONDATALEN 100
 #endif
 
+// How many pipelined QoS 1 publishes may await their PUBACK at the same time,
+// see publishPipelined(). Every one of them keeps a copy of its packet
+// (MAXBUFFERSIZE bytes) for retransmission.
+#ifndef MQTT_INFLIGHT_WINDOW
+#if defined(__AVR_ATmega32U4__) || defined(__AVR_ATmega328P__)
+#define MQTT_INFLIGHT_WINDOW 2
+#else
+#define MQTT_INFLIGHT_WINDOW 8
+#endif
+#endif
+
 class AdafruitIO_MQTT; // forward decl
 
 // Function pointer that returns an int
@@ -143,6 +158,44 @@ extern void printBuffer(uint8_t *buffer, uint16_t len);
 
 class Adafruit_MQTT_Subscribe; // forward decl
 
+// Incremental decoder of incoming MQTT packets. Received bytes are fed in
+// whatever chunks they arrive, the decoder tracks the fixed header and the
+// remaining length across calls and reports when a packet is complete. A
+// packet that doesn't fit into the buffer is truncated, its remaining bytes
+// are consumed and dropped so the stream stays in sync.
+class Adafruit_MQTT_PacketDecoder {
+public:
+  Adafruit_MQTT_PacketDecoder(uint8_t *buffer, uint16_t maxsize);
+
+  // Feed up to len received bytes. Stops after the last byte of a packet and
+  // returns how many bytes were consumed.
+  uint16_t feed(const uint8_t *data, uint16_t len);
+
+  // True once a whole packet has been fed, it stays in the buffer until
+  // reset() is called.
+  bool complete() const { return state == COMPLETE; }
+
+  // Bytes the current packet still needs, at least 1 while its length is
+  // unknown. Reading no more than this never consumes a following packet.
+  uint32_t needed() const;
+
+  // Length of the packet in the buffer (truncated to the buffer size).
+  uint16_t length() const { return len; }
+
+  // Start over with the next packet.
+  void reset();
+
+private:
+  enum State { TYPE, LENGTH, PAYLOAD, COMPLETE };
+
+  uint8_t *buffer;
+  uint16_t maxsize;
+  uint16_t len;       // bytes stored in buffer
+  uint32_t remaining; // payload bytes still expected
+  uint32_t multiplier;
+  State state;
+};
+
 class Adafruit_MQTT {
 public:
   Adafruit_MQTT(const char *server, uint16_t port, const char *cid,
@@ -193,6 +246,40 @@ public:
   bool publish(const char *topic, uint8_t *payload, uint16_t bLen,
                uint8_t qos = 0);
 
+  // Publish a message with QoS 1 without waiting for its PUBACK. Up to
+  // MQTT_INFLIGHT_WINDOW publishes can be in flight, so a batch of messages
+  // costs a single round trip instead of one per message. If the window is
+  // full, waits up to PUBLISH_TIMEOUT_MS for a PUBACK to free a slot. Returns
+  // false if the packet couldn't be sent or the window stayed full.
+  bool publishPipelined(const char *topic, uint8_t *payload, uint16_t bLen);
+
+  // Publish a message without copying it into the packet buffer: the fixed
+  // header and topic are sent from the packet buffer, the payload directly
+  // from the caller's memory. Payloads can therefore exceed MAXBUFFERSIZE (up
+  // to 64 KB). With QoS 1 it waits for the PUBACK like publish(), but there
+  // is no copy to retransmit, so a lost publish has to be repeated by the
+  // caller. Returns true if the message was published.
+  bool publishDirect(const char *topic, const uint8_t *payload, uint16_t bLen,
+                     uint8_t qos = 0);
+
+  // Process incoming packets for up to timeout milliseconds or until every
+  // pipelined publish has been acknowledged. PUBACKs are matched to the
+  // in-flight publishes by their packet id, publishes that haven't been
+  // acknowledged within MQTT_RETRANSMIT_MS are sent again. Returns true if
+  // no publish is in flight anymore.
+  bool flushPipelined(uint16_t timeout);
+
+  // Process every packet that has already arrived (PUBACKs of pipelined
+  // publishes, subscription messages) without waiting for more.
+  void poll();
+
+  // Number of pipelined publishes awaiting their PUBACK.
+  uint8_t inflight();
+
+  // Forget every pipelined publish awaiting its PUBACK, they are neither
+  // retransmitted nor acknowledged anymore.
+  void discardInflight();
+
   // Add a subscription to receive messages for a topic.  Returns true if the
   // subscription could be added or was already present, false otherwise.
   // Must be called before connect(), subscribing after the connection
@@ -237,8 +324,11 @@ protected:
   virtual uint16_t readPacket(uint8_t *buffer, uint16_t maxlen,
                               int16_t timeout) = 0;
 
-  // Read a full packet, keeping note of the correct length
-  uint16_t readFullPacket(uint8_t *buffer, uint16_t maxsize, uint16_t timeout);
+  // Read a full packet, keeping note of the correct length. Subclasses that
+  // can decode packets incrementally override this with a non-blocking
+  // version, so readSubscription(0) and poll() return at once.
+  virtual uint16_t readFullPacket(uint8_t *buffer, uint16_t maxsize,
+                                  uint16_t timeout);
   // Properly process packets until you get to one you want
   uint16_t processPacketsUntil(uint8_t *buffer, uint8_t waitforpackettype,
                                uint16_t timeout);
@@ -260,6 +350,25 @@ protected:
 private:
   Adafruit_MQTT_Subscribe *subscriptions[MAXSUBSCRIPTIONS];
 
+  // A pipelined QoS 1 publish awaiting its PUBACK.
+  struct InflightPublish {
+    uint16_t packetid; // 0 if the slot is free
+    uint16_t len;
+    uint32_t sent; // millis() of the last transmission
+    uint8_t packet[MAXBUFFERSIZE];
+  };
+  InflightPublish inflightPublishes[MQTT_INFLIGHT_WINDOW];
+
+  // Read one packet and acknowledge the matching in-flight publish if it's a
+  // PUBACK. Returns false if no packet arrived within the timeout.
+  bool processPubacks(uint16_t timeout);
+  // Act on a packet read into buffer that nobody was waiting for.
+  void handlePacket(uint16_t len);
+  // Move packet_id_counter to an id that isn't in flight.
+  void reservePacketId();
+  // Resend in-flight publishes, all of them or only overdue ones.
+  bool retransmitInflight(bool all);
+
   void flushIncoming(uint16_t timeout);
 
   // Functions to generate MQTT packets.
@@ -267,6 +376,8 @@ private:
   uint8_t disconnectPacket(uint8_t *packet);
   uint16_t publishPacket(uint8_t *packet, const char *topic, uint8_t *payload,
                          uint16_t bLen, uint8_t qos, uint16_t maxPacketLen = 0);
+  uint16_t publishHeader(uint8_t *packet, const char *topic, uint16_t bLen,
+                         uint8_t qos);
   uint8_t subscribePacket(uint8_t *packet, const char *topic, uint8_t qos);
   uint8_t unsubscribePacket(uint8_t *packet, const char *topic);
   uint8_t pingPacket(uint8_t *packet);
@@ -21,7 +21,14 @@
 // SOFTWARE.
 #include "Adafruit_MQTT_Client.h"
 
+#if defined(ESP32)
+#include <lwip/sockets.h>
+#endif
+
 bool Adafruit_MQTT_Client::connectServer() {
+  // A partly received packet belongs to the old connection, which may have
+  // dropped without disconnectServer().
+  decoder.reset();
   // Grab server name from flash and copy to buffer for name resolution.
   memset(buffer, 0, sizeof(buffer));
   strcpy((char *)buffer, servername);
@@ -40,6 +47,8 @@ bool Adafruit_MQTT_Client::disconnectServer() {
   if (client->connected()) {
     client->stop();
   }
+  // A partly received packet belongs to the old connection.
+  decoder.reset();
   return true;
 }
 
@@ -81,14 +90,76 @@ uint16_t Adafruit_MQTT_Client::readPacket(uint8_t *buffer, uint16_t maxlen,
   return len;
 }
 
+uint16_t Adafruit_MQTT_Client::readFullPacket(uint8_t *buffer,
+                                              uint16_t maxsize,
+                                              uint16_t timeout) {
+  uint32_t start = millis();
+  while (true) {
+    // Take what has already arrived, but never more than the current packet
+    // needs.
+    while (!decoder.complete()) {
+      int available = client->available();
+      if (available <= 0)
+        break;
+      uint8_t chunk[32];
+      uint32_t n = decoder.needed();
+      if (n > (uint32_t)available)
+        n = available;
+      if (n > sizeof(chunk))
+        n = sizeof(chunk);
+      int r = client->read(chunk, n);
+      if (r <= 0)
+        break;
+      decoder.feed(chunk, r);
+    }
+
+    if (decoder.complete()) {
+      uint16_t len = decoder.length();
+      if (len > maxsize)
+        len = maxsize;
+      memcpy(buffer, rxbuffer, len);
+      decoder.reset();
+      DEBUG_PRINT(F("Read data:\t"));
+      DEBUG_PRINTBUFFER(buffer, len);
+      return len;
+    }
+
+    uint32_t elapsed = millis() - start;
+    if (elapsed >= timeout || !client->connected())
+      return 0;
+    waitAvailable(timeout - elapsed);
+  }
+}
+
+void Adafruit_MQTT_Client::waitAvailable(uint16_t timeout) {
+#if defined(ESP32)
+  // Nothing is buffered by the WiFiClient anymore (available() was 0), so
+  // the socket becoming readable is the next event.
+  int fd = wificlient ? wificlient->fd() : -1;
+  if (fd >= 0) {
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(fd, &readable);
+    struct timeval tv;
+    tv.tv_sec = timeout / 1000;
+    tv.tv_usec = (timeout % 1000) * 1000;
+    select(fd + 1, &readable, NULL, NULL, &tv);
+    return;
+  }
+#endif
+  delay(timeout < MQTT_CLIENT_READINTERVAL_MS ? timeout
+                                              : MQTT_CLIENT_READINTERVAL_MS);
+}
+
 bool Adafruit_MQTT_Client::sendPacket(uint8_t *buffer, uint16_t len) {
   uint16_t ret = 0;
   uint16_t offset = 0;
   while (len > 0) {
     if (client->connected()) {
-      // send 250 bytes at most at a time, can adjust this later based on Client
+      // send MQTT_CLIENT_SENDCHUNK bytes at most at a time
 
-      uint16_t sendlen = len > 250 ? 250 : len;
+      uint16_t sendlen =
+          len > MQTT_CLIENT_SENDCHUNK ? MQTT_CLIENT_SENDCHUNK : len;
       // Serial.print("Sending: "); Serial.println(sendlen);
       ret = client->write(buffer + offset, sendlen);
       DEBUG_PRINT(F("Client sendPacket returned: "));
@@ -25,9 +25,23 @@
 #include "Adafruit_MQTT.h"
 #include "Client.h"
 
+#if defined(ESP32)
+#include <WiFiClient.h>
+#endif
+
 // How long to delay waiting for new data to be available in readPacket.
 #define MQTT_CLIENT_READINTERVAL_MS 10
 
+// Largest write handed to the Client at once by sendPacket. The WiFiClient of
+// the ESP32 takes a whole TCP segment (the default MSS of ESP-IDF).
+#ifndef MQTT_CLIENT_SENDCHUNK
+#if defined(ESP32)
+#define MQTT_CLIENT_SENDCHUNK 1436
+#else
+#define MQTT_CLIENT_SENDCHUNK 250
+#endif
+#endif
+
 // MQTT client implementation for a generic Arduino Client interface.  Can work
 // with almost all Arduino network hardware like ethernet shield, wifi shield,
 // and even other platforms like ESP8266.
@@ -35,11 +49,28 @@ class Adafruit_MQTT_Client : public Adafruit_MQTT {
 public:
   Adafruit_MQTT_Client(Client *client, const char *server, uint16_t port,
                        const char *cid, const char *user, const char *pass)
-      : Adafruit_MQTT(server, port, cid, user, pass), client(client) {}
+      : Adafruit_MQTT(server, port, cid, user, pass), client(client),
+        decoder(rxbuffer, sizeof(rxbuffer)) {}
 
   Adafruit_MQTT_Client(Client *client, const char *server, uint16_t port,
                        const char *user = "", const char *pass = "")
-      : Adafruit_MQTT(server, port, user, pass), client(client) {}
+      : Adafruit_MQTT(server, port, user, pass), client(client),
+        decoder(rxbuffer, sizeof(rxbuffer)) {}
+
+#if defined(ESP32)
+  // With a WiFiClient the receive path sleeps on the socket (select())
+  // instead of polling every MQTT_CLIENT_READINTERVAL_MS, so a CONNACK,
+  // PUBACK or PINGRESP is handled as soon as it arrives.
+  Adafruit_MQTT_Client(WiFiClient *client, const char *server, uint16_t port,
+                       const char *cid, const char *user, const char *pass)
+      : Adafruit_MQTT(server, port, cid, user, pass), client(client),
+        wificlient(client), decoder(rxbuffer, sizeof(rxbuffer)) {}
+
+  Adafruit_MQTT_Client(WiFiClient *client, const char *server, uint16_t port,
+                       const char *user = "", const char *pass = "")
+      : Adafruit_MQTT(server, port, user, pass), client(client),
+        wificlient(client), decoder(rxbuffer, sizeof(rxbuffer)) {}
+#endif
 
   bool connected() override;
 
@@ -48,10 +79,23 @@ protected:
   bool disconnectServer() override;
   uint16_t readPacket(uint8_t *buffer, uint16_t maxlen,
                       int16_t timeout) override;
+  // Feeds whatever has arrived into the packet decoder and only waits if the
+  // packet is still incomplete. A partly received packet is kept for the
+  // next call, a timeout of 0 never blocks.
+  uint16_t readFullPacket(uint8_t *buffer, uint16_t maxsize,
+                          uint16_t timeout) override;
   bool sendPacket(uint8_t *buffer, uint16_t len) override;
 
 private:
   Client *client;
+#if defined(ESP32)
+  WiFiClient *wificlient = NULL;
+#endif
+  uint8_t rxbuffer[MAXBUFFERSIZE];
+  Adafruit_MQTT_PacketDecoder decoder;
+
+  // Wait up to timeout milliseconds for data to arrive.
+  void waitAvailable(uint16_t timeout);
 };
 
 #endif
@@ -425,7 +425,40 @@ void SoftwareSerial::rxBits() {
     }
 #endif
 
-    m_isrBuffer->for_each(m_isrBufferForEachDel);
+#if SWSERIAL_RX_STATS
+    const uint32_t decodeStart = ESP.getCycleCount();
+#endif
+    // Drain the ISR buffer in blocks: one acquire/release of the queue positions per block
+    // instead of per edge. Every word whose edges are complete in the block is decoded by
+    // rxWord() in one step, the edges of a word that is not complete yet stay in the block
+    // while more edges are popped. Only edges that don't start a word, and the edges of a
+    // word still being received once the ISR buffer is empty, take the per-edge path.
+    constexpr size_t ISR_BLOCK_SIZE = 32;
+    uint32_t isrCycles[ISR_BLOCK_SIZE];
+    size_t edges = 0;
+    size_t popped;
+    do {
+        popped = m_isrBuffer->pop_n(isrCycles + edges, ISR_BLOCK_SIZE - edges);
+        edges += popped;
+        size_t i = 0;
+        while (i < edges) {
+            const size_t used = rxWord(isrCycles + i, edges - i);
+            if (used) {
+                i += used;
+            }
+            else if (popped && rxAtStartBit() && edges - i < ISR_BLOCK_SIZE / 2) {
+                break;
+            }
+            else {
+                rxBits(isrCycles[i++]);
+            }
+        }
+        edges -= i;
+        memmove(isrCycles, isrCycles + i, edges * sizeof(isrCycles[0]));
+    } while (popped);
+#if SWSERIAL_RX_STATS
+    m_decodeCycles += ESP.getCycleCount() - decodeStart;
+#endif
 
     // A stop bit can go undetected if leading data bits are at same level
     // and there was also no next start bit yet, so one word may be pending.
@@ -486,27 +519,7 @@ void SoftwareSerial::rxBits(const uint32_t& isrCycle) {
             // if not high stop bit level, discard word
             if (level)
             {
-                m_rxCurByte >>= (sizeof(uint8_t) * 8 - m_dataBits);
-                if (!m_buffer->push(m_rxCurByte)) {
-                    m_overflow = true;
-                }
-                else {
-                    if (m_parityBuffer)
-                    {
-                        if (m_rxCurParity) {
-                            m_parityBuffer->pushpeek() |= m_parityInPos;
-                        }
-                        else {
-                            m_parityBuffer->pushpeek() &= ~m_parityInPos;
-                        }
-                        m_parityInPos <<= 1;
-                        if (!m_parityInPos)
-                        {
-                            m_parityBuffer->push();
-                            m_parityInPos = 1;
-                        }
-                    }
-                }
+                rxStore(m_rxCurByte >> (sizeof(uint8_t) * 8 - m_dataBits), m_rxCurParity);
             }
             m_rxCurBit = m_pduBits;
             // reset to 0 is important for masked bit logic
@@ -518,6 +531,66 @@ void SoftwareSerial::rxBits(const uint32_t& isrCycle) {
     }
 }
 
+size_t SoftwareSerial::rxWord(const uint32_t* isrCycles, size_t edges) {
+    if (!rxAtStartBit()) return 0;
+
+    // Bit positions are counted from the start bit edge, the start bit is position 0 and
+    // the first stop bit position m_pduBits - m_stopBits + 1. Bit (position - 1) of word
+    // holds the level at that position, so the data bits end up in the low bits.
+    const uint32_t start = m_isrLastCycle;
+    const uint32_t stopPos = m_pduBits - m_stopBits + 1;
+    uint32_t word = 0;
+    uint32_t pos = 1;
+    bool level = false;
+    for (size_t i = 0; i < edges; ++i) {
+        const uint32_t edgePos = (isrCycles[i] - start + (m_bitCycles >> 1)) / m_bitCycles;
+        // glitch shorter than a bit, left to the per-edge path
+        if (edgePos < pos) return 0;
+        // the level of the previous edge lasts up to this edge
+        const uint32_t end = min(edgePos, stopPos + 1);
+        if (level) { word |= ((1UL << (end - pos)) - 1) << (pos - 1); }
+        pos = end;
+        if (edgePos > stopPos) {
+            // the level of every bit of the word is known, this edge ends it like rxBits(isrCycle) would
+            m_isrLastCycle = isrCycles[i];
+            if (word & (1UL << (stopPos - 1))) {
+                rxStore(word & ((1UL << m_dataBits) - 1), word & (1UL << m_dataBits));
+            }
+            m_rxCurBit = m_pduBits;
+            return i + 1;
+        }
+        level = (isrCycles[i] & 1) ^ m_invert;
+        ++pos;
+        if (level) { word |= 1UL << (edgePos - 1); }
+    }
+    // word not complete yet
+    return 0;
+}
+
+void SoftwareSerial::rxStore(uint8_t byte, bool parity) {
+    // Store the received value in the buffer unless we have an overflow
+    if (!m_buffer->push(byte)) {
+        m_overflow = true;
+    }
+    else {
+        if (m_parityBuffer)
+        {
+            if (parity) {
+                m_parityBuffer->pushpeek() |= m_parityInPos;
+            }
+            else {
+                m_parityBuffer->pushpeek() &= ~m_parityInPos;
+            }
+            m_parityInPos <<= 1;
+            if (!m_parityInPos)
+            {
+                m_parityBuffer->push();
+                m_parityInPos = 1;
+            }
+        }
+    }
+}
+
 void IRAM_ATTR SoftwareSerial::rxBitISR(SoftwareSerial* self) {
     uint32_t curCycle = ESP.getCycleCount();
     bool level = digitalRead(self->m_rxPin);
@@ -525,6 +598,11 @@ void IRAM_ATTR SoftwareSerial::rxBitISR(SoftwareSerial* self) {
     // Store level and cycle in the buffer unless we have an overflow
     // cycle's LSB is repurposed for the level bit
     if (!self->m_isrBuffer->push((curCycle | 1U) ^ !level)) self->m_isrOverflow.store(true);
+
+#if SWSERIAL_RX_STATS
+    ++self->m_isrCount;
+    self->m_isrCycles += ESP.getCycleCount() - curCycle;
+#endif
 }
 
 void IRAM_ATTR SoftwareSerial::rxBitSyncISR(SoftwareSerial* self) {
@@ -548,6 +626,11 @@ void IRAM_ATTR SoftwareSerial::rxBitSyncISR(SoftwareSerial* self) {
             level = !level;
         }
     }
+
+#if SWSERIAL_RX_STATS
+    ++self->m_isrCount;
+    self->m_isrCycles += ESP.getCycleCount() - start;
+#endif
 }
 
 void SoftwareSerial::onReceive(Delegate<void(int available), void*> handler) {
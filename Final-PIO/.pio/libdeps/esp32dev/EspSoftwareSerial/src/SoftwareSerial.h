@@ -206,6 +206,27 @@ public:
     /// from loop, or otherwise scheduled.
     void perform_work();
 
+#if SWSERIAL_RX_STATS
+    /// Cumulative receive cost, in CPU cycles. The ISR cycles are counted from ISR
+    /// entry to the push into the ISR buffer, interrupt dispatch is not included.
+    /// Only compiled in with the build flag SWSERIAL_RX_STATS, otherwise the ISRs
+    /// don't count anything.
+    struct RxStats {
+        uint32_t isrCount;
+        uint32_t isrCycles;
+        uint32_t decodeCycles;
+    };
+    /// Returns the receive cost since begin() or the last resetRxStats().
+    RxStats rxStats() const {
+        return { m_isrCount, m_isrCycles, m_decodeCycles };
+    }
+    void resetRxStats() {
+        m_isrCount = 0;
+        m_isrCycles = 0;
+        m_decodeCycles = 0;
+    }
+#endif
+
     using Print::write;
 
 private:
@@ -225,6 +246,10 @@ private:
     /* check m_rxValid that calling is safe */
     void rxBits();
     void rxBits(const uint32_t& isrCycle);
+    // no word in progress and the line low since the last edge
+    bool rxAtStartBit() const { return m_rxCurBit >= m_pduBits - 1 && !((m_isrLastCycle & 1) ^ m_invert); }
+    size_t rxWord(const uint32_t* isrCycles, size_t edges);
+    void rxStore(uint8_t byte, bool parity);
 
     static void rxBitISR(SoftwareSerial* self);
     static void rxBitSyncISR(SoftwareSerial* self);
@@ -260,10 +285,14 @@ private:
     // the ISR stores the relative bit times in the buffer. The inversion corrected level is used as sign bit (2's complement):
     // 1 = positive including 0, 0 = negative.
     std::unique_ptr<circular_queue<uint32_t, SoftwareSerial*> > m_isrBuffer;
-    const Delegate<void(unsigned int&&), SoftwareSerial*> m_isrBufferForEachDel = { [](SoftwareSerial* self, uint32_t&& isrCycle) { self->rxBits(isrCycle); }, this };
     std::atomic<bool> m_isrOverflow;
     uint32_t m_isrLastCycle;
     bool m_rxCurParity = false;
+#if SWSERIAL_RX_STATS
+    volatile uint32_t m_isrCount = 0;
+    volatile uint32_t m_isrCycles = 0;
+    uint32_t m_decodeCycles = 0;
+#endif
     Delegate<void(int available), void*> receiveHandler;
 };
 
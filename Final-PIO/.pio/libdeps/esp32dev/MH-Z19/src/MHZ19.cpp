@@ -457,6 +457,98 @@ void MHZ19::printCommunication(bool isDec, bool isPrintComm)
     this->storage.settings.printcomm = isPrintComm;
 }
 
+/*####################-Event Driven Functions-#####################*/
+
+void MHZ19::requestCO2(bool isunLimited)
+{
+    /* a skipped ABC cycle is requested the same way, its response is ignored */
+    ABCCheckAsync();
+
+    constructCommand(isunLimited ? CO2UNLIM : CO2LIM);
+
+    if (this->storage.settings.printcomm == true)
+        printstream(this->storage.constructedCommand, true, this->errorCode);
+
+    /* no flush(), bytes are sent by the UART while the caller continues */
+    mySerial->write(this->storage.constructedCommand, MHZ19_DATA_LEN);
+
+    this->pendingCommand = this->storage.constructedCommand[2];
+    this->requestTimeStamp = millis();
+    this->reading.status = RESULT_NULL;
+}
+
+void MHZ19::onReceive()
+{
+    /* single producer, only rxHead is written here */
+    byte head = this->rxHead.load(std::memory_order_relaxed);
+    while (mySerial->available() > 0)
+    {
+        byte next = (head + 1) & (MHZ19_RING_LEN - 1);
+
+        /* ring full, leave remaining bytes in the serial buffer */
+        if (next == this->rxTail.load(std::memory_order_acquire))
+            break;
+
+        this->rxRing[head] = mySerial->read();
+        head = next;
+        this->rxHead.store(head, std::memory_order_release);
+    }
+}
+
+byte MHZ19::processFrames()
+{
+    byte frames = 0;
+    byte frame[MHZ19_DATA_LEN];
+
+    /* single consumer, only rxTail is written here */
+    byte tail = this->rxTail.load(std::memory_order_relaxed);
+    while (((this->rxHead.load(std::memory_order_acquire) - tail) & (MHZ19_RING_LEN - 1)) >= MHZ19_DATA_LEN)
+    {
+        for (byte i = 0; i < MHZ19_DATA_LEN; i++)
+            frame[i] = this->rxRing[(tail + i) & (MHZ19_RING_LEN - 1)];
+
+        /* resynchronise on start byte / checksum by dropping a single byte */
+        if (frame[0] != 255 || frame[8] != getCRC(frame))
+        {
+            /* the response of the request is corrupt, the request is finished so later commands aren't blocked until the timeout */
+            if (frame[0] == 255 && this->pendingCommand != 0 && this->pendingCommand == frame[1])
+            {
+                this->pendingCommand = 0;
+                this->reading.status = RESULT_CRC;
+                this->errorCode = RESULT_CRC;
+            }
+
+            tail = (tail + 1) & (MHZ19_RING_LEN - 1);
+            this->rxTail.store(tail, std::memory_order_release);
+            continue;
+        }
+
+        tail = (tail + MHZ19_DATA_LEN) & (MHZ19_RING_LEN - 1);
+        this->rxTail.store(tail, std::memory_order_release);
+
+        if (this->storage.settings.printcomm == true)
+            printstream(frame, false, RESULT_OK);
+
+        handleFrame(frame);
+        frames++;
+    }
+
+    if (this->pendingCommand != 0 && millis() - this->requestTimeStamp >= TIMEOUT_PERIOD)
+    {
+        #if defined (ESP32) && (MHZ19_ERRORS)
+        ESP_LOGW(TAG_MHZ19, "Timed out waiting for response");
+        #elif MHZ19_ERRORS
+        Serial.println("!Error: Timed out waiting for response");
+        #endif
+
+        this->pendingCommand = 0;
+        this->reading.status = RESULT_TIMEOUT;
+        this->errorCode = RESULT_TIMEOUT;
+    }
+
+    return frames;
+}
+
 /*######################-Inernal Functions-########################*/
 
 void MHZ19::provisioning(Command_Type commandtype, int inData)
@@ -726,6 +818,52 @@ void MHZ19::ABCCheck()
 	}
 }
 
+void MHZ19::ABCCheckAsync()
+{
+	if (((millis() - ABCRepeatTimer) >= 4.32e7) && (this->storage.settings.ABCRepeat == true))
+	{
+		ABCRepeatTimer = millis();
+
+		constructCommand(ABC, MHZ19_ABC_PERIOD_OFF);
+		mySerial->write(this->storage.constructedCommand, MHZ19_DATA_LEN);
+	}
+}
+
+void MHZ19::handleFrame(byte inBytes[MHZ19_DATA_LEN])
+{
+    /* same assignment as handleResponse() */
+    if (inBytes[1] == Commands[RAWCO2])
+        memcpy(this->storage.responses.RAW, inBytes, MHZ19_DATA_LEN);
+
+    else if (inBytes[1] == Commands[CO2UNLIM])
+    {
+        memcpy(this->storage.responses.CO2UNLIM, inBytes, MHZ19_DATA_LEN);
+        this->reading.CO2 = makeInt(inBytes[4], inBytes[5]);
+
+        if (this->reading.CO2 > 32767)
+            this->reading.CO2 = 32767;  // same overflow guard as getCO2()
+    }
+
+    else if (inBytes[1] == Commands[CO2LIM])
+    {
+        memcpy(this->storage.responses.CO2LIM, inBytes, MHZ19_DATA_LEN);
+        this->reading.CO2 = makeInt(inBytes[2], inBytes[3]);
+        this->reading.temperature = inBytes[4] - TEMP_ADJUST;
+    }
+
+    else
+        memcpy(this->storage.responses.STAT, inBytes, MHZ19_DATA_LEN);
+
+    /* responses to other commands (e.g. ABC) don't finish the outstanding request */
+    if (inBytes[1] == this->pendingCommand)
+    {
+        this->pendingCommand = 0;
+        this->reading.status = RESULT_OK;
+        this->reading.timeStamp = millis();
+        this->errorCode = RESULT_OK;
+    }
+}
+
 void MHZ19::makeByte(int inInt, byte *high, byte *low)
 {
     *high = (byte)(inInt / 256);
@@ -4,6 +4,7 @@
 #define MHZ19_H
 
 #include <Arduino.h>
+#include <atomic>
 
 #ifdef ESP32
 #include "esp32-hal-log.h"
@@ -19,6 +20,8 @@
 
 #define MHZ19_DATA_LEN 9		// Data protocl length
 
+#define MHZ19_RING_LEN 32		// Receive ring buffer length for the event driven reader (power of 2)
+
 // Command bytes -------------------------- //
 #define MHZ19_ABC_PERIOD_OFF    0x00
 #define MHZ19_ABC_PERIOD_DEF    0xA0
@@ -34,6 +37,15 @@ enum ERRORCODE
 	RESULT_FILTER = 5
 };
 
+/* Values published by the event driven reader */
+struct MHZ19Reading
+{
+	int CO2 = 0;						// ppm, from command 133 or 134 responses
+	int temperature = 0;				// whole degrees, only updated by command 134 responses
+	byte status = RESULT_NULL;			// errorcode of the last request (RESULT_OK, RESULT_CRC, RESULT_TIMEOUT)
+	unsigned long timeStamp = 0;		// millis() of the last valid response
+};
+
 class MHZ19
 {
   public:
@@ -42,6 +54,9 @@ class MHZ19
 	/* Holds last recieved errorcode from recieveResponse() */
 	byte errorCode;
 
+	/* Holds values decoded by processFrames() */
+	MHZ19Reading reading;
+
 	/* for keeping track of the ABC run interval */
 	unsigned long ABCRepeatTimer;
 
@@ -116,6 +131,17 @@ class MHZ19
 	/* use to show communication between MHZ19 and  Device */
 	void printCommunication(bool isDec = true, bool isPrintComm = true);
 
+	/*####################-Event Driven Functions-#####################*/
+
+	/* sends a CO2 request (command 133 or 134) without waiting for the response */
+	void requestCO2(bool isunLimited = true);
+
+	/* moves received bytes from the serial port into the ring buffer, never waits (can be used as serial receive callback) */
+	void onReceive();
+
+	/* assembles frames from the ring buffer and updates reading, never waits. Returns number of valid frames */
+	byte processFrames();
+
   private:
 	/*###########################-Variables-##########################*/
      
@@ -165,6 +191,13 @@ class MHZ19
 
 	} storage;
 
+	/* Event driven reader */
+	byte rxRing[MHZ19_RING_LEN];
+	std::atomic<byte> rxHead{0};				// written by onReceive(), published with release after the byte is stored
+	std::atomic<byte> rxTail{0};				// written by processFrames(), published with release after the frame is copied
+	byte pendingCommand = 0;					// command byte of the outstanding request, 0 if none
+	unsigned long requestTimeStamp = 0;
+
 	/*######################-Inernal Functions-########################*/
 
 	/* Coordinates  sending, constructing and recieving commands */
@@ -194,6 +227,12 @@ class MHZ19
 	/* Cheks whether time elapse for next ABC OFF cycle has occured */
 	void ABCCheck();
 
+	/* Same as ABCCheck(), but sends the command without waiting for the response */
+	void ABCCheckAsync();
+
+	/* Stores a validated frame in the matching communication array and updates reading */
+	void handleFrame(byte inBytes[MHZ19_DATA_LEN]);
+
 	/* converts integers to bytes according to /256 and %256 */
 	void makeByte(int inInt, byte *high, byte *low);
 
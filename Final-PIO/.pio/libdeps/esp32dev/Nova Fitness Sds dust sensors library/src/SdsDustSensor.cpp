@@ -1,6 +1,11 @@
 #include "SdsDustSensor.h"
 
 void SdsDustSensor::write(const Command &command) {
+  writeBytes(command);
+  delay(WRITE_DELAY_MS);
+}
+
+void SdsDustSensor::writeBytes(const Command &command) {
   for (int i = 0; i < Command::length; ++i) {
     sdsStream->write(command.bytes[i]);
     #ifdef __DEBUG_SDS_DUST_SENSOR__
@@ -11,7 +16,42 @@ void SdsDustSensor::write(const Command &command) {
   #ifdef __DEBUG_SDS_DUST_SENSOR__
   Serial.println("| <- written bytes");
   #endif
-  delay(500);
+}
+
+bool SdsDustSensor::poll() {
+  bool finished = false;
+  while (pending.isPending() && sdsStream->available() > 0) {
+    byte readByte = sdsStream->read();
+    #ifdef __DEBUG_SDS_DUST_SENSOR__
+    Serial.print("|");
+    Serial.print(readByte, HEX);
+    #endif
+    if (pending.feed(readByte)) {
+      #ifdef __DEBUG_SDS_DUST_SENSOR__
+      Serial.println("| <- pending request done");
+      #endif
+      finished = true;
+    }
+  }
+  return pending.expire(millis()) || finished;
+}
+
+bool SdsDustSensor::pollStream() {
+  bool received = false;
+  while (sdsStream->available() > 0) {
+    byte readByte = sdsStream->read();
+    #ifdef __DEBUG_SDS_DUST_SENSOR__
+    Serial.print("|");
+    Serial.print(readByte, HEX);
+    #endif
+    if (stream.feed(readByte)) {
+      #ifdef __DEBUG_SDS_DUST_SENSOR__
+      Serial.println("| <- streamed frame");
+      #endif
+      received = true;
+    }
+  }
+  return received;
 }
 
 Status SdsDustSensor::readIntoBytes(byte responseId) {
@@ -38,6 +78,18 @@ Status SdsDustSensor::readIntoBytes(byte responseId) {
         }
         break;
       case 2:
+        if (readByte != responseId && readByte == Commands::queryPm.responseId) {
+          // PM frame streamed in 'active' reporting mode before the sensor processed the command,
+          // the rest of it is already available (see loop condition), skip it and read the next frame
+          for (; readBytesQuantity < Result::lenght; ++readBytesQuantity) {
+            sdsStream->read();
+          }
+          #ifdef __DEBUG_SDS_DUST_SENSOR__
+          Serial.println("| <- skipped streamed frame");
+          #endif
+          readBytesQuantity = 0;
+          continue;
+        }
         if (readByte != responseId) {
           #ifdef __DEBUG_SDS_DUST_SENSOR__
           Serial.println("| <- read bytes with invalid response id");
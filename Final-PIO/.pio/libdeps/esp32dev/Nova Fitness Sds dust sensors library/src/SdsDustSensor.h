@@ -28,10 +28,13 @@
 
 #include "SdsDustSensorCommands.h"
 #include "SdsDustSensorResults.h"
+#include "SdsDustSensorPending.h"
+#include "SdsDustSensorStream.h"
 #include "Serials.h"
 
 #define RETRY_DELAY_MS_DEFAULT 5
 #define MAX_RETRIES_NOT_AVAILABLE_DEFAULT 100
+#define WRITE_DELAY_MS 500
 
 class SdsDustSensor {
 public:
@@ -168,7 +171,51 @@ public:
     return retryRead(command.responseId);
   }
 
+  // asynchronous mode: the command is written without waiting for the sensor,
+  // the response is assembled by subsequent 'poll' calls (see PendingRequest)
+  PendingRequest &queryPmAsync(PendingRequest::Callback callback = NULL, void *context = NULL) {
+    return executeAsync(Commands::queryPm, callback, context);
+  }
+
+  PendingRequest &executeAsync(const Command &command, PendingRequest::Callback callback = NULL, void *context = NULL) {
+    flushStream();
+    writeBytes(command);
+    pending.begin(command.responseId, millis(), asyncTimeoutMs(), callback, context);
+    return pending;
+  }
+
+  // warning: only one request can be pending at a time, issuing a new one replaces the previous one
+  PendingRequest &getPendingRequest() {
+    return pending;
+  }
+
+  // never blocks - consumes bytes that are already available, returns true only by the call that finished the pending request
+  // (the result stays available by 'getPendingRequest' until the next request is issued)
+  bool poll();
+
+  // streaming mode: puts the sensor into 'active' reporting mode, it then sends PM values
+  // every second (or every working period) without any command on the wire
+  ReportingModeResult beginStream() {
+    ReportingModeResult result = setActiveReportingMode();
+    flushStream();
+    return result;
+  }
+
+  // never blocks - consumes bytes that are already available, returns true if a new PM frame was received
+  // warning: sensor has to be in 'active' reporting mode and no request may be pending
+  bool pollStream();
+
+  // latest PM values received in streaming mode
+  PmResult getStreamPm() {
+    return stream.toPmResult();
+  }
+
+  FrameParser &getStreamParser() {
+    return stream;
+  }
+
   void write(const Command &command);
+  void writeBytes(const Command &command);
   Status readIntoBytes(byte responseId);
 
 private:
@@ -177,6 +224,13 @@ private:
   byte response[Result::lenght];
   int retryDelayMs;
   int maxRetriesNotAvailable;
+  PendingRequest pending;
+  FrameParser stream = FrameParser(Commands::queryPm.responseId);
+
+  // same time budget as the blocking mode: write delay plus all 'not available' retries
+  unsigned long asyncTimeoutMs() {
+    return WRITE_DELAY_MS + (unsigned long)retryDelayMs * maxRetriesNotAvailable;
+  }
 
   void flushStream();
   Status retryRead(byte responseId);
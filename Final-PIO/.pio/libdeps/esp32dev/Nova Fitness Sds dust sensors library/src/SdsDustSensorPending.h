@@ -0,0 +1,132 @@
+#ifndef __SDS_DUST_SENSOR_PENDING_H__
+#define __SDS_DUST_SENSOR_PENDING_H__
+
+#include "SdsDustSensorResults.h"
+
+// Handle of a command issued in asynchronous mode.
+// Incoming bytes are fed one by one, the response is validated the same way as in 'readIntoBytes'
+// (head, response id, checksum, tail). Unexpected head or response id bytes are skipped,
+// so a stale frame in the serial buffer doesn't fail the request.
+class PendingRequest {
+public:
+  typedef void (*Callback)(PendingRequest &request, void *context);
+
+  enum class State { Idle, Pending, Done };
+
+  void begin(byte responseId, unsigned long startMs, unsigned long timeoutMs,
+             Callback callback = NULL, void *context = NULL) {
+    this->responseId = responseId;
+    this->startMs = startMs;
+    this->timeoutMs = timeoutMs;
+    this->callback = callback;
+    this->context = context;
+    state = State::Pending;
+    status = Status::NotAvailable;
+    lastError = Status::NotAvailable;
+    received = 0;
+    checksum = 0;
+  }
+
+  // returns true if this byte completed the request (successfully or not)
+  bool feed(byte readByte) {
+    if (state != State::Pending) {
+      return false;
+    }
+
+    response[received++] = readByte;
+    switch (received) {
+      case 1:
+        if (readByte != Command::head) {
+          lastError = Status::InvalidHead;
+          received = 0;
+        }
+        break;
+      case 2:
+        if (readByte != responseId) {
+          lastError = Status::InvalidResponseId;
+          received = 0;
+          if (readByte == Command::head) {
+            response[received++] = readByte;
+          }
+        }
+        break;
+      case 3 ... 8:
+        checksum += readByte;
+        break;
+      case 9:
+        if (readByte != checksum % 256) {
+          finish(Status::InvalidChecksum);
+          return true;
+        }
+        break;
+      case 10:
+        finish(readByte == Command::tail ? Status::Ok : Status::InvalidTail);
+        return true;
+    }
+    if (received == 0) {
+      checksum = 0;
+    }
+    return false;
+  }
+
+  // finishes the request if no valid response arrived within the timeout, returns true if it did so
+  bool expire(unsigned long nowMs) {
+    if (state != State::Pending || nowMs - startMs < timeoutMs) {
+      return false;
+    }
+    finish(lastError);
+    return true;
+  }
+
+  // drops the request without invoking the callback
+  void cancel() {
+    state = State::Idle;
+  }
+
+  State getState() {
+    return state;
+  }
+
+  bool isPending() {
+    return state == State::Pending;
+  }
+
+  bool isDone() {
+    return state == State::Done;
+  }
+
+  Status getStatus() {
+    return status;
+  }
+
+  byte *getResponse() {
+    return response;
+  }
+
+  PmResult toPmResult() {
+    return PmResult(status, response);
+  }
+
+private:
+  State state = State::Idle;
+  Status status = Status::NotAvailable;
+  Status lastError = Status::NotAvailable;
+  byte response[Result::lenght];
+  byte responseId = 0;
+  int received = 0;
+  int checksum = 0;
+  unsigned long startMs = 0;
+  unsigned long timeoutMs = 0;
+  Callback callback = NULL;
+  void *context = NULL;
+
+  void finish(const Status &finalStatus) {
+    status = finalStatus;
+    state = State::Done;
+    if (callback != NULL) {
+      callback(*this, context);
+    }
+  }
+};
+
+#endif // __SDS_DUST_SENSOR_PENDING_H__
@@ -70,11 +70,15 @@ struct ReportingModeResult: public Result {
 struct PmResult: public Result {
   float pm25 = -1.0;
   float pm10 = -1.0;
+  int pm25Tenths = -1; // pm25 in 0.1 ug/m3 as sent by the sensor, no floating point involved
+  int pm10Tenths = -1; // pm10 in 0.1 ug/m3 as sent by the sensor, no floating point involved
 
   PmResult(const Status &status, byte *bytes): Result(status, bytes) {
     if (isOk()) {
-      pm25 = (rawBytes[2] | (rawBytes[3] << 8)) / 10.0;
-      pm10 = (rawBytes[4] | (rawBytes[5] << 8)) / 10.0;
+      pm25Tenths = rawBytes[2] | (rawBytes[3] << 8);
+      pm10Tenths = rawBytes[4] | (rawBytes[5] << 8);
+      pm25 = pm25Tenths / 10.0;
+      pm10 = pm10Tenths / 10.0;
     }
   }
 
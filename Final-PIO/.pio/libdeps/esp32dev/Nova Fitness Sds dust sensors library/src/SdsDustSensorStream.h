@@ -0,0 +1,107 @@
+#ifndef __SDS_DUST_SENSOR_STREAM_H__
+#define __SDS_DUST_SENSOR_STREAM_H__
+
+#include "SdsDustSensorResults.h"
+
+// Frame parser for the unsolicited frames sent in 'active' reporting mode.
+// Incoming bytes are fed one by one and validated the same way as in 'readIntoBytes'
+// (head, response id, checksum, tail). In contrast to 'readIntoBytes' an invalid frame
+// doesn't fail anything: the parser resynchronizes on the next head byte within the
+// bytes already received, so a frame starting inside a corrupted one is not lost.
+class FrameParser {
+public:
+  FrameParser(byte responseId): responseId(responseId) {}
+
+  // returns true if this byte completed a valid frame, see 'getFrame'
+  bool feed(byte readByte) {
+    frame[received++] = readByte;
+    while (received > 0) {
+      Status status = validate();
+      if (status == Status::NotAvailable) {
+        return false;
+      }
+      if (status == Status::Ok) {
+        for (int i = 0; i < Result::lenght; ++i) {
+          last[i] = frame[i];
+        }
+        received = 0;
+        ++frames;
+        return true;
+      }
+      lastError = status;
+      ++errors;
+      resync();
+    }
+    return false;
+  }
+
+  // last valid frame, Result::lenght bytes
+  byte *getFrame() {
+    return last;
+  }
+
+  // last valid frame, or the last error if no valid frame was received yet
+  PmResult toPmResult() {
+    return PmResult(frames > 0 ? Status::Ok : lastError, last);
+  }
+
+  // number of valid frames received
+  unsigned long getFrames() {
+    return frames;
+  }
+
+  // number of invalid frames skipped
+  unsigned long getErrors() {
+    return errors;
+  }
+
+  Status getLastError() {
+    return lastError;
+  }
+
+private:
+  byte frame[Result::lenght];
+  byte last[Result::lenght];
+  byte responseId;
+  int received = 0;
+  unsigned long frames = 0;
+  unsigned long errors = 0;
+  Status lastError = Status::NotAvailable;
+
+  // validates the bytes received so far, NotAvailable if they are a valid but incomplete frame
+  Status validate() {
+    if (frame[0] != Command::head) {
+      return Status::InvalidHead;
+    }
+    if (received >= 2 && frame[1] != responseId) {
+      return Status::InvalidResponseId;
+    }
+    if (received >= 9) {
+      int checksum = 0;
+      for (int i = 2; i < 8; ++i) {
+        checksum += frame[i];
+      }
+      if (frame[8] != checksum % 256) {
+        return Status::InvalidChecksum;
+      }
+    }
+    if (received == Result::lenght) {
+      return frame[9] == Command::tail ? Status::Ok : Status::InvalidTail;
+    }
+    return Status::NotAvailable;
+  }
+
+  // drops bytes up to the next head byte after the start of the current frame
+  void resync() {
+    int start = 1;
+    while (start < received && frame[start] != Command::head) {
+      ++start;
+    }
+    for (int i = start; i < received; ++i) {
+      frame[i - start] = frame[i];
+    }
+    received -= start;
+  }
+};
+
+#endif // __SDS_DUST_SENSOR_STREAM_H__
@@ -0,0 +1,139 @@
+/**
+ * @file AsyncConnection.h
+ * @author Simon Schimik
+ * @version 3.0
+ */
+
+#pragma once
+
+#include "Arduino.h"
+#include "Task.h"
+#include <atomic>
+#include <AsyncTCP.h>
+
+/**
+ * Connection of an AsyncClient, shared by AsyncMQTTClient and AsyncHTTPClient.
+ *
+ * Tracks whether the connection is being established or established and lets the owner give up an attempt that takes too long.
+ * AsyncClient::close() finds no connection to close before it's established, so onDisconnect() may never be called for an abandoned attempt:
+ * the state is reset right away by abandon() and a connection established after its attempt was abandoned is closed again.
+ * The state is guarded by the mutex of the owner, the Handler is called with the mutex locked.
+ */
+class AsyncConnection
+{
+  public:
+    enum class State : uint8_t
+    {
+      DISCONNECTED,
+      CONNECTING,
+      CONNECTED
+    };
+
+    /**
+     * Receives the changes of the connection, called in the AsyncTCP-task with the mutex locked.
+     */
+    class Handler
+    {
+      public:
+        /** The connection is established. */
+        virtual void onConnected() = 0;
+
+        /**
+         * The connection is closed, not called for an abandoned attempt.
+         *
+         * @param established false if the connection attempt failed.
+         */
+        virtual void onClosed(bool established) = 0;
+
+        virtual ~Handler() {}
+    };
+
+    AsyncClient client; ///< data and ACKs are handled by the owner
+
+  private:
+    Mutex& mutex;
+    Handler& handler;
+    std::atomic<uint8_t> state;
+    uint32_t since = 0; ///< millis() of the last change of the state
+
+    void setState(State newState)
+    {
+      state.store((uint8_t)newState);
+      since = millis();
+    }
+
+    void onConnect()
+    {
+      {
+        MutexLock lock(mutex);
+        if(getState() == State::CONNECTING)
+        {
+          setState(State::CONNECTED);
+          handler.onConnected();
+          return;
+        }
+      }
+      client.close(true); // connected after the attempt was abandoned
+    }
+
+    void onDisconnect()
+    {
+      MutexLock lock(mutex);
+      State previous = getState();
+      if(previous == State::DISCONNECTED) return; // abandoned attempt
+      setState(State::DISCONNECTED);
+      handler.onClosed(previous == State::CONNECTED);
+    }
+
+  public:
+    /**
+     * @param mutex Mutex of the owner guarding the connection.
+     * @param handler Handler of the owner.
+     */
+    AsyncConnection(Mutex& mutex, Handler& handler) : mutex(mutex), handler(handler)
+    {
+      setState(State::DISCONNECTED);
+      client.onConnect([this](void*, AsyncClient*) { onConnect(); });
+      client.onDisconnect([this](void*, AsyncClient*) { onDisconnect(); });
+    }
+
+    State getState() const { return (State)state.load(); }
+
+    /** @return ms since the connection attempt started or the connection was established. Locked by the caller. */
+    uint32_t elapsed() const { return millis() - since; }
+
+    /**
+     * Starts connecting unless connected or connecting, doesn't wait for the connection.
+     *
+     * Must not be called with the mutex locked or from within an AsyncClient-callback, since connecting replaces the connection of the callback.
+     *
+     * @return false if connecting couldn't be started.
+     */
+    bool connect(const char* host, uint16_t port)
+    {
+      {
+        MutexLock lock(mutex);
+        if(getState() != State::DISCONNECTED) return true;
+        setState(State::CONNECTING);
+      }
+      if(client.connect(host, port)) return true;
+      MutexLock lock(mutex);
+      setState(State::DISCONNECTED);
+      return false;
+    }
+
+    /**
+     * Gives up a pending connection attempt, the connection can be started again right away. Locked by the caller.
+     *
+     * @return true if an attempt was given up.
+     */
+    bool abandon()
+    {
+      if(getState() != State::CONNECTING) return false;
+      setState(State::DISCONNECTED);
+      return true;
+    }
+
+    /** Closes the connection, must not be called with the mutex locked since onClosed() follows. */
+    void close() { client.close(true); }
+};
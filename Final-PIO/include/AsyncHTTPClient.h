@@ -0,0 +1,434 @@
+/**
+ * @file AsyncHTTPClient.h
+ * @author Simon Schimik
+ * @version 3.0
+ */
+
+#pragma once
+
+#include "Arduino.h"
+#include "config.h"
+#include "Task.h"
+#include "Scheduler.h"
+#include "SensorSample.h"
+#include "AsyncConnection.h"
+#include <HTTPClient.h>
+#include "esp_timer.h"
+
+/**
+ * HTTP/1.1 client posting to a fixed URL on the event driven AsyncClient of AsyncTCP.
+ *
+ * Nothing blocks: post() copies the body into the request queue and returns, connecting, sending and parsing the response happen in the
+ * AsyncTCP-task. The requests are sent one after another over a kept alive connection. A request succeeds with a 2xx-status, otherwise the
+ * queue is paused until retryFailed() is called, so the outcome is reported to the caller and the request retried in order.
+ * A periodic timer fails a request that takes longer than HTTP_TIMEOUT (connect, send and response).
+ * Error codes are those of HTTPClient (HTTPC_ERROR_*), only http:// URLs are supported.
+ *
+ * @tparam BODY_SIZE Largest body of a request.
+ * @tparam QUEUE_SIZE Number of requests that can be queued.
+ */
+template<size_t BODY_SIZE, uint8_t QUEUE_SIZE>
+class AsyncHTTPClient : private AsyncConnection::Handler
+{
+  private:
+    /** Period of the timeout timer in ms. */
+    static const uint32_t TICK_MS = 250;
+
+    static const size_t HEAD_SIZE = 256;
+
+    /** State of the response parser. */
+    enum class Parse : uint8_t
+    {
+      STATUS,
+      HEADERS,
+      BODY,
+      CHUNK_SIZE,
+      CHUNK_DATA,
+      CHUNK_END,   ///< line break after the data of a chunk
+      TRAILERS,
+      UNTIL_CLOSE, ///< body without length, ends with the connection
+      COMPLETE
+    };
+
+    struct Request
+    {
+      uint16_t samples;
+      uint16_t headLength;
+      uint16_t bodyLength;
+      uint16_t sent; ///< bytes of head and body handed to the connection
+      char head[HEAD_SIZE];
+      uint8_t body[BODY_SIZE];
+    };
+
+    char host[64];
+    uint16_t port = 80;
+    char prefix[HEAD_SIZE]; ///< request head up to the value of Content-Length, built once
+    size_t prefixLength = 0;
+
+    esp_timer_handle_t timer = NULL;
+    mutable Mutex mutex; ///< guards everything below, the callbacks run in the AsyncTCP-task and the timer-task
+    AsyncConnection connection;
+
+    Request queue[QUEUE_SIZE];
+    uint8_t head = 0;
+    uint8_t count = 0;
+
+    uint16_t served = 0;  ///< requests completed on the current connection
+    bool active = false;  ///< the request at the head is being processed
+    bool paused = false;  ///< the request at the head failed, see retryFailed()
+    int failure = 0;
+    bool reuse = false;   ///< the active request is sent over a kept alive connection
+    uint32_t started = 0; ///< millis() when the active request was started
+    int64_t startedMicros = 0;
+
+    Parse parse = Parse::STATUS;
+    char line[96];
+    uint8_t lineLength = 0;
+    int status = 0;
+    int32_t contentLength = -1;
+    uint32_t remaining = 0;
+    bool chunked = false;
+    bool closeAfter = false; ///< the server closes the connection after the response
+    bool responded = false;
+
+    uint32_t requests = 0;
+    uint32_t reused = 0;
+    int64_t latencySum = 0;
+    int64_t latencyMax = 0;
+
+    /** Sends the head and body of the active request, as much as the TCP window takes. Locked by the caller. */
+    void send()
+    {
+      if(!active || connection.getState() != AsyncConnection::State::CONNECTED) return;
+      Request& request = queue[head];
+      bool added = false;
+      while(request.sent < request.headLength + request.bodyLength)
+      {
+        bool inHead = request.sent < request.headLength;
+        const char* data = inHead ? request.head + request.sent : (const char*)request.body + request.sent - request.headLength;
+        size_t size = inHead ? request.headLength - request.sent : request.headLength + request.bodyLength - request.sent;
+        if(size > connection.client.space()) size = connection.client.space();
+        size = size ? connection.client.add(data, size) : 0;
+        if(size == 0) break; // the rest once the server ACKed
+        request.sent += size;
+        added = true;
+      }
+      if(added) connection.client.send();
+    }
+
+    /** Starts the request at the head on the open connection. Locked by the caller. */
+    void begin()
+    {
+      queue[head].sent = 0;
+      reuse = served > 0;
+      parse = Parse::STATUS;
+      lineLength = 0;
+      status = 0;
+      contentLength = -1;
+      chunked = false;
+      closeAfter = false;
+      responded = false;
+      send();
+    }
+
+    /**
+     * Starts the next request unless one is active or the queue is paused, connects first if necessary.
+     *
+     * Must not be called from within an AsyncClient-callback, since connecting replaces the connection of the callback.
+     */
+    void start()
+    {
+      {
+        MutexLock lock(mutex);
+        if(active || paused || count == 0) return;
+        active = true;
+        started = millis();
+        startedMicros = monotonicMicros();
+        if(connection.getState() == AsyncConnection::State::CONNECTED)
+        {
+          begin();
+          return;
+        }
+      }
+      if(connection.connect(host, port)) return; // begins once connected
+      MutexLock lock(mutex);
+      finish(HTTPC_ERROR_CONNECTION_REFUSED);
+    }
+
+    /**
+     * Ends the active request, a successful one is removed from the queue and the next one begun on the same connection. Locked by the caller.
+     *
+     * @param code HTTP-status or HTTPC_ERROR_*.
+     * @return true if the connection has to be closed.
+     */
+    bool finish(int code)
+    {
+      int64_t latency = monotonicMicros() - startedMicros;
+      requests++;
+      if(reuse) reused++;
+      latencySum += latency;
+      if(latency > latencyMax) latencyMax = latency;
+      active = false;
+      served++;
+
+      if(code < 200 || code >= 300)
+      {
+        log_d("AsyncHTTPClient: request failed (%d) after %lldus", code, latency);
+        failure = code;
+        paused = true;
+        return true; // the retry starts on a new connection
+      }
+
+      log_d("AsyncHTTPClient: %u samples acknowledged after %lldus, connection reused %u of %u requests", queue[head].samples, latency, reused, requests);
+      queue[head].samples = 0;
+      head = (head + 1) % QUEUE_SIZE;
+      count--;
+      if(closeAfter) return true;
+      if(count && connection.getState() == AsyncConnection::State::CONNECTED)
+      {
+        active = true;
+        started = millis();
+        startedMicros = monotonicMicros();
+        begin();
+      }
+      return false;
+    }
+
+    /** Acts on a line of the response head or of the chunk framing. Locked by the caller. */
+    void parseLine()
+    {
+      line[lineLength] = '\0';
+      switch(parse)
+      {
+        case Parse::STATUS:
+          if(lineLength < 12 || strncmp(line, "HTTP/1.", 7) != 0)
+          {
+            status = HTTPC_ERROR_NO_HTTP_SERVER;
+            parse = Parse::COMPLETE;
+            break;
+          }
+          status = atoi(line + 9);
+          parse = Parse::HEADERS;
+          break;
+        case Parse::HEADERS:
+          if(lineLength == 0)
+          {
+            if(status < 200) parse = Parse::STATUS; // 100 Continue, the actual response follows
+            else if(status == 204 || status == 304) parse = Parse::COMPLETE;
+            else if(chunked) parse = Parse::CHUNK_SIZE;
+            else if(contentLength >= 0) parse = (remaining = contentLength) ? Parse::BODY : Parse::COMPLETE;
+            else parse = Parse::UNTIL_CLOSE;
+            break;
+          }
+          for(uint8_t i = 0; i < lineLength; i++) line[i] = tolower(line[i]);
+          if(strncmp(line, "content-length:", 15) == 0) contentLength = strtol(line + 15, NULL, 10);
+          else if(strncmp(line, "transfer-encoding:", 18) == 0) chunked = strstr(line, "chunked") != NULL;
+          else if(strncmp(line, "connection:", 11) == 0) closeAfter = strstr(line, "close") != NULL;
+          break;
+        case Parse::CHUNK_SIZE:
+          remaining = strtoul(line, NULL, 16);
+          parse = remaining ? Parse::CHUNK_DATA : Parse::TRAILERS;
+          break;
+        case Parse::CHUNK_END:
+          parse = Parse::CHUNK_SIZE;
+          break;
+        case Parse::TRAILERS:
+          if(lineLength == 0) parse = Parse::COMPLETE;
+          break;
+        default:
+          break;
+      }
+    }
+
+    void onConnected()
+    {
+      served = 0;
+      if(active) begin();
+    }
+
+    void onClosed(bool established)
+    {
+      if(!active) return;
+      if(parse == Parse::UNTIL_CLOSE) finish(status);
+      else if(reuse && !responded) active = false; // the server closed the kept alive connection, started again on a new one by tick()
+      else finish(established ? HTTPC_ERROR_CONNECTION_LOST : HTTPC_ERROR_CONNECTION_REFUSED);
+    }
+
+    void onData(const uint8_t* data, size_t length)
+    {
+      bool close = false;
+      {
+        MutexLock lock(mutex);
+        if(!active) return;
+        responded = true;
+        for(size_t i = 0; i < length && parse != Parse::COMPLETE && parse != Parse::UNTIL_CLOSE; i++)
+        {
+          if(parse == Parse::BODY || parse == Parse::CHUNK_DATA)
+          {
+            size_t skip = length - i < remaining ? length - i : remaining; // the body isn't needed
+            i += skip - 1;
+            remaining -= skip;
+            if(!remaining) parse = parse == Parse::BODY ? Parse::COMPLETE : Parse::CHUNK_END;
+            continue;
+          }
+          char c = data[i];
+          if(c == '\n')
+          {
+            parseLine();
+            lineLength = 0;
+          }
+          else if(c != '\r' && lineLength < sizeof(line) - 1)
+          {
+            line[lineLength++] = c;
+          }
+        }
+        if(parse == Parse::COMPLETE) close = finish(status);
+      }
+      if(close) connection.close(); // calls onClosed(), the next request is started by tick()
+    }
+
+    void onAck()
+    {
+      MutexLock lock(mutex);
+      send();
+    }
+
+    /**
+     * Timeout timer, fails a request that takes longer than HTTP_TIMEOUT and starts the next one if none is active.
+     */
+    void tick()
+    {
+      bool close = false;
+      {
+        MutexLock lock(mutex);
+        if(active && millis() - started > HTTP_TIMEOUT)
+        {
+          connection.abandon();
+          close = finish(HTTPC_ERROR_READ_TIMEOUT);
+        }
+      }
+      if(close) connection.close();
+      start();
+    }
+
+  public:
+    /**
+     * @param url URL the requests are posted to, http://host[:port]/path.
+     * @param contentType Content-Type of the bodies.
+     */
+    AsyncHTTPClient(const char* url, const char* contentType) : connection(mutex, *this)
+    {
+      if(strncmp(url, "http://", 7) == 0) url += 7;
+      size_t hostLength = strcspn(url, ":/");
+      if(hostLength >= sizeof(host)) hostLength = sizeof(host) - 1;
+      memcpy(host, url, hostLength);
+      host[hostLength] = '\0';
+      url += strcspn(url, ":/");
+      if(*url == ':') port = strtoul(url + 1, (char**)&url, 10);
+      const char* path = *url == '/' ? url : "/";
+
+      int length = snprintf(prefix, sizeof(prefix), "POST %s HTTP/1.1\r\nHost: %s\r\nContent-Type: %s\r\nConnection: keep-alive\r\nContent-Length: ",
+                            path, host, contentType);
+      prefixLength = length < 0 ? 0 : length;
+      if(prefixLength > sizeof(prefix) - 16)
+      {
+        log_e("AsyncHTTPClient: URL too long");
+        prefixLength = 0;
+      }
+
+      connection.client.onData([this](void*, AsyncClient*, void* data, size_t length) { onData((const uint8_t*)data, length); });
+      connection.client.onAck([this](void*, AsyncClient*, size_t, uint32_t) { onAck(); });
+
+      esp_timer_create_args_t args = {};
+      args.callback = [](void* arg) { static_cast<AsyncHTTPClient*>(arg)->tick(); };
+      args.arg = this;
+      args.name = "http";
+      if(esp_timer_create(&args, &timer) == ESP_OK) esp_timer_start_periodic(timer, TICK_MS * 1000);
+    }
+
+    ~AsyncHTTPClient()
+    {
+      if(timer)
+      {
+        esp_timer_stop(timer);
+        esp_timer_delete(timer);
+      }
+      connection.close();
+    }
+
+    /**
+     * Queues a request, it's sent once the requests before are done.
+     *
+     * @param body Body of the request, copied.
+     * @param length Length of body.
+     * @param samples Samples held by the body, see queued().
+     * @return false if the queue is full or the body exceeds BODY_SIZE.
+     */
+    bool post(const uint8_t* body, size_t length, uint16_t samples)
+    {
+      {
+        MutexLock lock(mutex);
+        if(count == QUEUE_SIZE || length > BODY_SIZE || prefixLength == 0) return false;
+        Request& request = queue[(head + count) % QUEUE_SIZE];
+        memcpy(request.head, prefix, prefixLength);
+        size_t headLength = prefixLength + formatUnsigned(request.head + prefixLength, HEAD_SIZE - prefixLength, length);
+        memcpy(request.head + headLength, "\r\n\r\n", 4);
+        request.headLength = headLength + 4;
+        memcpy(request.body, body, length);
+        request.bodyLength = length;
+        request.samples = samples;
+        request.sent = 0;
+        count++;
+      }
+      start();
+      return true;
+    }
+
+    /**
+     * Reports a failed request and starts it again.
+     *
+     * @return HTTP-status or HTTPC_ERROR_* of the failed request at the head of the queue, 0 if no request failed.
+     */
+    int retryFailed()
+    {
+      int code;
+      {
+        MutexLock lock(mutex);
+        if(!paused) return 0;
+        paused = false;
+        code = failure;
+      }
+      start();
+      return code;
+    }
+
+    /** @return number of samples held by the queued requests. */
+    uint16_t queued() const
+    {
+      MutexLock lock(mutex);
+      uint16_t samples = 0;
+      for(uint8_t i = 0; i < count; i++) samples += queue[(head + i) % QUEUE_SIZE].samples;
+      return samples;
+    }
+
+    /** @return share of the requests sent over a kept alive connection in 0.1 %. */
+    uint16_t getReuseRatio() const
+    {
+      MutexLock lock(mutex);
+      return requests == 0 ? 0 : (uint64_t)reused * 1000 / requests;
+    }
+
+    /** @return mean latency of the requests in us (from starting the request until the response is complete). */
+    int64_t getMeanLatency() const
+    {
+      MutexLock lock(mutex);
+      return requests == 0 ? 0 : latencySum / requests;
+    }
+
+    /** @return largest latency of the requests in us. */
+    int64_t getMaxLatency() const
+    {
+      MutexLock lock(mutex);
+      return latencyMax;
+    }
+};
@@ -0,0 +1,400 @@
+/**
+ * @file AsyncMQTTClient.h
+ * @author Simon Schimik
+ * @version 3.0
+ */
+
+#pragma once
+
+#include "Arduino.h"
+#include "config.h"
+#include "Task.h"
+#include "AsyncConnection.h"
+#include <atomic>
+#include "esp_timer.h"
+#include "Adafruit_MQTT.h"
+
+/**
+ * MQTT 3.1.1 client on the event driven AsyncClient of AsyncTCP.
+ *
+ * Nothing blocks: publish() only encodes the packet into the outbound queue, the queue is written to the connection whenever the TCP window
+ * has space (after every publish, on the CONNACK and on every ACK of the broker). Received bytes are decoded incrementally in the AsyncTCP-task
+ * (see Adafruit_MQTT_PacketDecoder). QoS 1 packets stay queued until their PUBACK arrived and are sent again as duplicate after a reconnect.
+ * A periodic timer sends the keep-alive PINGREQ and closes a connection whose CONNACK or PINGRESP is overdue.
+ *
+ * @tparam PACKET_SIZE Largest packet.
+ * @tparam QUEUE_SIZE Number of packets the outbound queue holds.
+ */
+template<size_t PACKET_SIZE, uint8_t QUEUE_SIZE>
+class AsyncMQTTClient : private AsyncConnection::Handler
+{
+  public:
+    enum class State : uint8_t
+    {
+      DISCONNECTED,
+      CONNECTING, ///< TCP-connection or CONNACK pending
+      CONNECTED
+    };
+
+  private:
+    /** Period of the keep-alive timer in ms. */
+    static const uint32_t TICK_MS = 1000;
+
+    /**
+     * A packet of the outbound queue.
+     */
+    struct Outbound
+    {
+      uint16_t length = 0;   ///< 0 if the slot is free
+      uint16_t sent = 0;     ///< bytes handed to the connection
+      uint16_t packetId = 0; ///< 0 for QoS 0, which is freed once it's sent
+      uint8_t packet[PACKET_SIZE];
+    };
+
+    const char* host;
+    uint16_t port;
+    const char* clientId;
+    const char* user;
+    const char* pass;
+    uint16_t keepAlive; ///< s
+
+    esp_timer_handle_t timer = NULL;
+    mutable Mutex mutex; ///< guards everything below, the callbacks run in the AsyncTCP-task and the timer-task
+    AsyncConnection connection;
+    std::atomic<bool> acknowledged; ///< the CONNACK of the connection arrived
+
+    Outbound queue[QUEUE_SIZE]; ///< ring buffer, slots are allocated at the tail and freed in any order
+    uint8_t head = 0;
+    uint8_t count = 0;
+    uint16_t packetId = 0;
+
+    uint8_t received[MAXBUFFERSIZE];
+    Adafruit_MQTT_PacketDecoder decoder;
+
+    uint32_t lastSent = 0;
+    uint32_t pingSent = 0;
+    bool pingPending = false;
+
+    static uint8_t* putLength(uint8_t* position, uint32_t length)
+    {
+      do
+      {
+        uint8_t encoded = length % 128;
+        length /= 128;
+        *position++ = length ? encoded | 0x80 : encoded;
+      }while(length);
+      return position;
+    }
+
+    static uint8_t* putString(uint8_t* position, const char* text, size_t length)
+    {
+      *position++ = length >> 8;
+      *position++ = length & 0xFF;
+      memcpy(position, text, length);
+      return position + length;
+    }
+
+    /** Frees the slots at the head, slots freed out of order are reused once the head reached them. */
+    void compact()
+    {
+      while(count && queue[head].length == 0)
+      {
+        head = (head + 1) % QUEUE_SIZE;
+        count--;
+      }
+    }
+
+    /** @return a packet id that is neither 0 nor queued. */
+    uint16_t reservePacketId()
+    {
+      bool used;
+      do
+      {
+        if(++packetId == 0) packetId = 1;
+        used = false;
+        for(const Outbound& slot : queue) used = used || (slot.length && slot.packetId == packetId);
+      }while(used);
+      return packetId;
+    }
+
+    /**
+     * Writes queued packets to the connection, as much as the TCP window takes. Locked by the caller.
+     */
+    void send()
+    {
+      if(!connected()) return;
+      bool added = false;
+      for(uint8_t i = 0; i < count; i++)
+      {
+        Outbound& slot = queue[(head + i) % QUEUE_SIZE];
+        if(slot.length == 0 || slot.sent == slot.length) continue;
+        size_t size = connection.client.space();
+        if(size > (size_t)(slot.length - slot.sent)) size = slot.length - slot.sent;
+        size = size ? connection.client.add((const char*)slot.packet + slot.sent, size) : 0;
+        if(size == 0) break;
+        slot.sent += size;
+        added = true;
+        if(slot.sent < slot.length) break; // the rest once the broker ACKed
+        if(slot.packetId == 0) slot.length = 0;
+      }
+      if(!added) return;
+      connection.client.send();
+      lastSent = millis();
+      compact();
+    }
+
+    /** Sends the CONNECT-packet. Locked by the caller. */
+    void sendConnect()
+    {
+      size_t clientIdLength = strlen(clientId);
+      size_t userLength = strlen(user);
+      size_t passLength = strlen(pass);
+      uint8_t packet[128];
+      if(12 + clientIdLength + 2 + userLength + 2 + passLength > sizeof(packet))
+      {
+        log_e("AsyncMQTTClient: credentials too long");
+        return;
+      }
+
+      uint8_t flags = 0x02; // clean session
+      if(userLength) flags |= 0x80;
+      if(passLength) flags |= 0x40;
+      uint32_t length = 10 + 2 + clientIdLength + (userLength ? 2 + userLength : 0) + (passLength ? 2 + passLength : 0);
+
+      uint8_t* position = packet;
+      *position++ = MQTT_CTRL_CONNECT << 4;
+      position = putLength(position, length);
+      position = putString(position, "MQTT", 4);
+      *position++ = 4; // protocol level of MQTT 3.1.1
+      *position++ = flags;
+      *position++ = keepAlive >> 8;
+      *position++ = keepAlive & 0xFF;
+      position = putString(position, clientId, clientIdLength);
+      if(userLength) position = putString(position, user, userLength);
+      if(passLength) position = putString(position, pass, passLength);
+      connection.client.add((const char*)packet, position - packet);
+      connection.client.send();
+      lastSent = millis();
+    }
+
+    /**
+     * Acts on a received packet. Locked by the caller.
+     *
+     * @return false if the connection has to be closed.
+     */
+    bool handlePacket()
+    {
+      uint16_t length = decoder.length();
+      switch(received[0] >> 4)
+      {
+        case MQTT_CTRL_CONNECTACK:
+          if(length < 4 || received[3] != 0)
+          {
+            log_e("AsyncMQTTClient: connection refused (%u)", length < 4 ? 0 : received[3]);
+            return false;
+          }
+          acknowledged.store(true);
+          pingPending = false;
+          // packets the previous connection didn't finish or that weren't acknowledged are sent again
+          for(Outbound& slot : queue)
+          {
+            if(!slot.length || !slot.sent) continue;
+            slot.sent = 0;
+            if(slot.packetId) slot.packet[0] |= 0x08; // DUP
+          }
+          send();
+          return true;
+        case MQTT_CTRL_PUBACK:
+          if(length == 4)
+          {
+            uint16_t id = ((uint16_t)received[2] << 8) | received[3];
+            for(Outbound& slot : queue) if(slot.length && slot.packetId == id) slot.length = 0;
+            compact();
+          }
+          return true;
+        case MQTT_CTRL_PINGRESP:
+          pingPending = false;
+          return true;
+        default:
+          return true; // nothing subscribed
+      }
+    }
+
+    void onConnected()
+    {
+      decoder.reset();
+      sendConnect();
+    }
+
+    void onClosed(bool)
+    {
+      acknowledged.store(false);
+    }
+
+    void onData(uint8_t* data, size_t length)
+    {
+      bool close = false;
+      {
+        MutexLock lock(mutex);
+        while(length && !close)
+        {
+          uint16_t used = decoder.feed(data, length > 0xFFFF ? 0xFFFF : length);
+          data += used;
+          length -= used;
+          if(!decoder.complete()) continue;
+          close = !handlePacket();
+          decoder.reset();
+        }
+      }
+      if(close) connection.close(); // calls onClosed()
+    }
+
+    void onAck()
+    {
+      MutexLock lock(mutex);
+      send();
+    }
+
+    /**
+     * Keep-alive timer, sends the PINGREQ and closes a connection whose CONNACK or PINGRESP is overdue.
+     */
+    void tick()
+    {
+      bool close = false;
+      {
+        MutexLock lock(mutex);
+        uint32_t now = millis();
+        switch(getState())
+        {
+          case State::CONNECTING:
+            // TCP-connection or CONNACK overdue
+            close = connection.elapsed() > MQTT_ASYNC_CONNECT_TIMEOUT;
+            if(close) connection.abandon();
+            break;
+          case State::CONNECTED:
+            if(pingPending)
+            {
+              close = now - pingSent > keepAlive * 1000UL;
+              break;
+            }
+            send();
+            if(now - lastSent >= keepAlive * 500UL && connection.client.space() >= 2)
+            {
+              static const uint8_t ping[] = { MQTT_CTRL_PINGREQ << 4, 0 };
+              connection.client.add((const char*)ping, sizeof(ping));
+              connection.client.send();
+              lastSent = pingSent = now;
+              pingPending = true;
+            }
+            break;
+          default:
+            break;
+        }
+      }
+      if(close)
+      {
+        log_e("AsyncMQTTClient: broker not responding, closing connection");
+        connection.close();
+      }
+    }
+
+  public:
+    /**
+     * @param host Host name or IP of the broker.
+     * @param port Port of the broker.
+     * @param clientId Client id, may be empty since the session is clean.
+     * @param user User name, empty for none.
+     * @param pass Password, empty for none.
+     * @param keepAlive Keep-alive interval in s.
+     */
+    AsyncMQTTClient(const char* host, uint16_t port, const char* clientId, const char* user, const char* pass, uint16_t keepAlive) :
+      host(host), port(port), clientId(clientId), user(user), pass(pass), keepAlive(keepAlive), connection(mutex, *this),
+      decoder(received, sizeof(received))
+    {
+      acknowledged.store(false);
+      connection.client.onData([this](void*, AsyncClient*, void* data, size_t length) { onData((uint8_t*)data, length); });
+      connection.client.onAck([this](void*, AsyncClient*, size_t, uint32_t) { onAck(); });
+      connection.client.onTimeout([this](void*, AsyncClient*, uint32_t) { connection.close(); });
+
+      esp_timer_create_args_t args = {};
+      args.callback = [](void* arg) { static_cast<AsyncMQTTClient*>(arg)->tick(); };
+      args.arg = this;
+      args.name = "mqtt";
+      if(esp_timer_create(&args, &timer) == ESP_OK) esp_timer_start_periodic(timer, TICK_MS * 1000);
+    }
+
+    ~AsyncMQTTClient()
+    {
+      if(timer)
+      {
+        esp_timer_stop(timer);
+        esp_timer_delete(timer);
+      }
+      connection.close();
+    }
+
+    /**
+     * Starts connecting to the broker unless already connected or connecting, doesn't wait for the connection.
+     *
+     * @return false if connecting couldn't be started.
+     */
+    bool connect() { return connection.connect(host, port); }
+
+    /**
+     * Queues a packet, it's sent as soon as the broker is connected and the TCP window has space.
+     *
+     * @param qos 0 or 1, a QoS 1 packet stays queued until its PUBACK arrived.
+     * @return false if the queue is full or the packet exceeds PACKET_SIZE.
+     */
+    bool publish(const char* topic, const uint8_t* payload, uint16_t length, uint8_t qos)
+    {
+      size_t topicLength = strlen(topic);
+      uint32_t remaining = 2 + topicLength + (qos ? 2 : 0) + length;
+      if(1 + 4 + remaining > PACKET_SIZE) return false;
+
+      MutexLock lock(mutex);
+      if(count == QUEUE_SIZE) return false;
+      Outbound& slot = queue[(head + count) % QUEUE_SIZE];
+      uint8_t* position = slot.packet;
+      *position++ = MQTT_CTRL_PUBLISH << 4 | (qos ? MQTT_QOS_1 << 1 : 0);
+      position = putLength(position, remaining);
+      position = putString(position, topic, topicLength);
+      slot.packetId = 0;
+      if(qos)
+      {
+        slot.packetId = reservePacketId();
+        *position++ = slot.packetId >> 8;
+        *position++ = slot.packetId & 0xFF;
+      }
+      memcpy(position, payload, length);
+      slot.length = position + length - slot.packet;
+      slot.sent = 0;
+      count++;
+      send();
+      return true;
+    }
+
+    State getState() const
+    {
+      if(connection.getState() == AsyncConnection::State::DISCONNECTED) return State::DISCONNECTED;
+      return acknowledged.load() ? State::CONNECTED : State::CONNECTING;
+    }
+
+    bool connected() const { return getState() == State::CONNECTED; }
+
+    /** @return number of packets that can be queued, a caller publishing several packets checks that all of them fit before the first one. */
+    uint8_t available() const
+    {
+      MutexLock lock(mutex);
+      return QUEUE_SIZE - count;
+    }
+
+    /** @return number of packets queued or awaiting their PUBACK. */
+    uint8_t queued() const
+    {
+      MutexLock lock(mutex);
+      uint8_t packets = 0;
+      for(uint8_t i = 0; i < count; i++) if(queue[(head + i) % QUEUE_SIZE].length) packets++;
+      return packets;
+    }
+};
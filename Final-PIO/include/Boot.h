@@ -0,0 +1,170 @@
+/**
+ * @file Boot.h
+ * @author Simon Schimik
+ * @version 3.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include "Task.h"
+#include "Scheduler.h"
+
+/**
+ * Signature of a boot stage.
+ *
+ * @return false if the stage failed.
+ */
+typedef bool (*StageFunction)();
+
+/**
+ * State of a boot stage.
+ */
+enum class StageState : uint8_t
+{
+  WAITING, ///< waiting for its dependencies
+  RUNNING,
+  DONE,
+  FAILED,
+  SKIPPED  ///< not run because a dependency failed or was skipped
+};
+
+/**
+ * Runs the boot stages concurrently.
+ *
+ * Every stage runs in its own task as soon as all stages it depends on are done. Independent stages (f.e. sensors on different buses
+ * and the WiFi-connection) therefore overlap, and the boot takes as long as the slowest chain of dependent stages instead of the sum of all stages.
+ * Start and end of every stage are recorded as boot timeline.
+ */
+class BootOrchestrator
+{
+  public:
+    static const uint8_t MAX_STAGES = 16;
+
+    /**
+     * Timeline entry of a stage, times in us since run() was called.
+     */
+    struct StageTiming
+    {
+      const char* name;
+      StageState state;
+      int64_t start;
+      int64_t end;
+    };
+
+  private:
+    struct Stage
+    {
+      BootOrchestrator* boot;
+      const char* name;
+      StageFunction function;
+      uint16_t dependencies;
+      uint8_t core;
+      std::atomic<uint8_t> state;
+      int64_t start;
+      int64_t end;
+    };
+
+    Stage stages[MAX_STAGES];
+    uint8_t count = 0;
+    int64_t startTime = 0;
+
+    StageState getState(uint8_t stage) const { return (StageState)stages[stage].state.load(); }
+
+    /** @return DONE if all dependencies are done, SKIPPED if any failed or was skipped, WAITING otherwise. */
+    StageState dependencyState(uint16_t dependencies) const
+    {
+      StageState result = StageState::DONE;
+      for(uint8_t i = 0; i < count; i++)
+      {
+        if(!(dependencies & (1 << i))) continue;
+        StageState state = getState(i);
+        if(state == StageState::FAILED || state == StageState::SKIPPED) return StageState::SKIPPED;
+        if(state != StageState::DONE) result = StageState::WAITING;
+      }
+      return result;
+    }
+
+    static void runStage(void* arg)
+    {
+      Stage& stage = *static_cast<Stage*>(arg);
+      StageState dependencies;
+      while((dependencies = stage.boot->dependencyState(stage.dependencies)) == StageState::WAITING) taskDelay(1);
+
+      stage.start = monotonicMicros() - stage.boot->startTime;
+      StageState result = StageState::SKIPPED;
+      if(dependencies == StageState::DONE)
+      {
+        stage.state.store((uint8_t)StageState::RUNNING);
+        result = stage.function() ? StageState::DONE : StageState::FAILED;
+      }
+      stage.end = monotonicMicros() - stage.boot->startTime;
+      stage.state.store((uint8_t)result);
+      endTask();
+    }
+
+  public:
+    /**
+     * Adds a stage.
+     *
+     * @param name Name of the stage, also used as task name.
+     * @param function The stage function.
+     * @param dependencies Stages that have to be done before this one starts, combined by |.
+     * @param core Core the stage runs on.
+     * @return The stage as dependency for other stages, 0 if MAX_STAGES is exceeded.
+     */
+    uint16_t addStage(const char* name, StageFunction function, uint16_t dependencies = 0, uint8_t core = 1)
+    {
+      if(count >= MAX_STAGES) return 0;
+      Stage& stage = stages[count];
+      stage.boot = this;
+      stage.name = name;
+      stage.function = function;
+      stage.dependencies = dependencies;
+      stage.core = core;
+      stage.state.store((uint8_t)StageState::WAITING);
+      stage.start = stage.end = 0;
+      return 1 << count++;
+    }
+
+    /**
+     * Runs all stages and waits until every stage is finished.
+     *
+     * @param stackSize Stack size of every stage task in bytes.
+     * @param priority Priority of the stage tasks.
+     * @return true if all stages are done.
+     */
+    bool run(uint32_t stackSize, uint8_t priority = 1)
+    {
+      startTime = monotonicMicros();
+      for(uint8_t i = 0; i < count; i++)
+      {
+        if(!startTask(runStage, stages[i].name, stackSize, &stages[i], priority, stages[i].core)) stages[i].state.store((uint8_t)StageState::FAILED);
+      }
+
+      bool finished;
+      do
+      {
+        taskDelay(10);
+        finished = true;
+        for(uint8_t i = 0; i < count; i++)
+        {
+          StageState state = getState(i);
+          if(state == StageState::WAITING || state == StageState::RUNNING) finished = false;
+        }
+      }while(!finished);
+
+      for(uint8_t i = 0; i < count; i++) if(getState(i) != StageState::DONE) return false;
+      return true;
+    }
+
+    /** @return number of stages. */
+    uint8_t stageCount() const { return count; }
+
+    /** @return timeline entry of the stage. */
+    StageTiming getTiming(uint8_t stage) const
+    {
+      return { stages[stage].name, getState(stage), stages[stage].start, stages[stage].end };
+    }
+};
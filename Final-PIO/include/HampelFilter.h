@@ -0,0 +1,86 @@
+/**
+ * @file HampelFilter.h
+ * @author Simon Schimik
+ * @version 3.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Streaming Hampel filter rejecting outliers of a single metric.
+ *
+ * A reading is suspect if it deviates from the median of the previous N readings by more than threshold times the scale.
+ * The scale is a running estimate of the mean absolute deviation from the median, it never drops below a floor,
+ * otherwise a perfectly constant signal (f.e. CO2 in an empty room) would turn every change into an outlier.
+ * Suspect readings are still added to the window, so a real step in the signal is accepted once it makes up half of the window.
+ *
+ * Memory is fixed (2 * N values). Per reading the window is searched binary and shifted by memmove, with N being small that's negligible.
+ * @tparam N Number of readings in the window.
+ */
+template<uint8_t N>
+class HampelFilter
+{
+  private:
+    int32_t ring[N];   ///< readings in arrival order
+    int32_t sorted[N]; ///< the same readings in ascending order
+    uint8_t count = 0;
+    uint8_t next = 0;
+    int32_t scale = 0;
+
+    /** @return index of the first element in sorted not smaller than value. */
+    uint8_t lowerBound(int32_t value) const
+    {
+      uint8_t low = 0, high = count;
+      while(low < high)
+      {
+        uint8_t mid = (low + high) / 2;
+        if(sorted[mid] < value) low = mid + 1;
+        else high = mid;
+      }
+      return low;
+    }
+
+    void insert(int32_t value)
+    {
+      if(count == N)
+      {
+        uint8_t oldest = lowerBound(ring[next]);
+        memmove(&sorted[oldest], &sorted[oldest + 1], (count - oldest - 1) * sizeof(int32_t));
+        count--;
+      }
+      uint8_t position = lowerBound(value);
+      memmove(&sorted[position + 1], &sorted[position], (count - position) * sizeof(int32_t));
+      sorted[position] = value;
+      count++;
+
+      ring[next] = value;
+      next = (next + 1) % N;
+    }
+
+  public:
+    /**
+     * Filters a reading.
+     *
+     * @param value The fixed point reading.
+     * @param floor Smallest scale in fixed point, deviations up to threshold * floor are never suspect.
+     * @param threshold Allowed deviation in multiples of the scale.
+     * @return true if the reading is suspect.
+     */
+    bool isOutlier(int32_t value, int32_t floor, uint8_t threshold)
+    {
+      bool suspect = false;
+      if(count == N) // warming up until the window is full, every reading is accepted
+      {
+        int32_t median = sorted[N / 2];
+        int32_t deviation = value > median ? value - median : median - value;
+        int32_t limit = (scale > floor ? scale : floor) * threshold;
+        suspect = deviation > limit;
+        if(!suspect) scale += (deviation - scale) / 8;
+      }
+      insert(value);
+      return suspect;
+    }
+};
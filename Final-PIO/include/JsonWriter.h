@@ -0,0 +1,130 @@
+/**
+ * @file JsonWriter.h
+ * @author Simon Schimik
+ * @version 3.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "SensorSample.h"
+
+/** Largest value formatted by formatFixed() or formatUnsigned(), f.e. "-21474836.47". */
+constexpr size_t JSON_VALUE_LENGTH = 12;
+
+/** @return length of a zero-terminated string, at compile time. */
+constexpr size_t constLength(const char* text)
+{
+  return *text ? 1 + constLength(text + 1) : 0;
+}
+
+/** @return length of one member "keysuffix":"value" including the separating comma. */
+constexpr size_t jsonMemberLength(size_t key, size_t suffix, size_t value)
+{
+  return key + suffix + value + 6;
+}
+
+/** @return largest length of the member of a field with the given suffix and value length. */
+constexpr size_t jsonMemberLength(const FieldDescriptor& field, Suffix::Id suffix, size_t value)
+{
+  return jsonMemberLength(constLength(field.jsonKey), constLength(SUFFIXES[suffix]), value);
+}
+
+/** @return largest length of all members of one field written by forEachPublishedValue(). */
+constexpr size_t jsonFieldLength(const FieldDescriptor& field, bool summary)
+{
+  return (summary ? jsonMemberLength(field, Suffix::NONE, JSON_VALUE_LENGTH) + jsonMemberLength(field, Suffix::MINIMUM, JSON_VALUE_LENGTH)
+                    + jsonMemberLength(field, Suffix::MAXIMUM, JSON_VALUE_LENGTH) + jsonMemberLength(field, Suffix::STDDEV, JSON_VALUE_LENGTH)
+                    + jsonMemberLength(field, Suffix::SAMPLES, 5)
+                  : jsonMemberLength(field, Suffix::NONE, JSON_VALUE_LENGTH))
+         + jsonMemberLength(field, Suffix::SUSPECT, 1) + jsonMemberLength(field, Suffix::WARMING, 1);
+}
+
+/**
+ * @return largest length of all members written by forEachPublishedValue(), computed from FIELDS at compile time.
+ */
+constexpr size_t jsonFieldsLength(bool summary, uint8_t field = 0)
+{
+  return field == Field::COUNT ? 0 : jsonFieldLength(FIELDS[field], summary) + jsonFieldsLength(summary, field + 1);
+}
+
+/**
+ * @return buffer size needed for an object of members of the given total length (see jsonMemberLength()), including braces and the terminating zero.
+ */
+constexpr size_t jsonObjectSize(size_t members)
+{
+  return members + 2;
+}
+
+/**
+ * Writes a flat JSON object of string members into a fixed buffer.
+ *
+ * Nothing is allocated, the buffer is provided by the caller and sized at compile time (see jsonObjectSize()).
+ * Keys and values are written as they are, they must not need escaping (field keys and formatted numbers don't).
+ */
+class JsonWriter
+{
+  private:
+    char* buffer;
+    size_t size;
+    size_t length = 0;
+    bool empty = true;
+    bool overflow = false;
+
+    void put(char c)
+    {
+      if(length + 1 < size) buffer[length++] = c;
+      else overflow = true;
+    }
+
+    void append(const char* text)
+    {
+      while(*text) put(*text++);
+    }
+
+  public:
+    /**
+     * Starts the object.
+     *
+     * @param buffer Receives the zero-terminated object.
+     * @param size Size of buffer.
+     */
+    JsonWriter(char* buffer, size_t size) : buffer(buffer), size(size)
+    {
+      put('{');
+    }
+
+    /**
+     * Adds the member "keysuffix":"value".
+     */
+    void member(const char* key, const char* suffix, const char* value)
+    {
+      if(!empty) put(',');
+      empty = false;
+      put('"');
+      append(key);
+      append(suffix);
+      append("\":\"");
+      append(value);
+      put('"');
+    }
+
+    /**
+     * Closes the object.
+     *
+     * @return The zero-terminated object.
+     */
+    const char* end()
+    {
+      put('}');
+      if(size > 0) buffer[length] = '\0';
+      return buffer;
+    }
+
+    /** @return length of the object without the terminating zero. */
+    size_t getLength() const { return length; }
+
+    /** @return true if the object didn't fit into the buffer and has been truncated. */
+    bool overflowed() const { return overflow; }
+};
@@ -0,0 +1,70 @@
+/**
+ * @file LoadMeter.h
+ * @author Simon Schimik
+ * @version 3.0
+ */
+
+#pragma once
+
+#include "Task.h"
+#include "Scheduler.h"
+
+/**
+ * Measures the CPU load of one core.
+ *
+ * A task with the lowest priority spins on the core and counts its iterations. It only gets the CPU time no other task
+ * or ISR needs, the load is therefore 1 - (iterations per ms / iterations per ms of the idle core).
+ * Unlike instrumenting single ISRs this covers everything running on the core, including ISRs of the ESP-IDF drivers (f.e. UART).
+ */
+class LoadMeter
+{
+  private:
+    volatile uint32_t spins = 0;
+    uint32_t baseline = 0;  ///< iterations per ms of the idle core
+    uint32_t lastSpins = 0;
+    int64_t lastTime = 0;
+
+    static void run(void* arg)
+    {
+      LoadMeter* self = static_cast<LoadMeter*>(arg);
+      for(;;) self->spins++;
+    }
+
+  public:
+    /**
+     * Starts the spinning task and calibrates the idle iteration rate.
+     *
+     * Must be called while the core is otherwise idle, the calling task is blocked during calibration.
+     * @param core The core to be measured.
+     * @param calibrationMs Duration of the calibration in ms.
+     * @return false if the task couldn't be started.
+     */
+    bool begin(uint8_t core, uint32_t calibrationMs = 1000)
+    {
+      if(!startTask(run, "loadmeter", 1024, this, 0, core)) return false;
+      uint32_t start = spins;
+      taskDelay(calibrationMs);
+      baseline = (spins - start) / calibrationMs;
+      lastSpins = spins;
+      lastTime = monotonicMicros();
+      return true;
+    }
+
+    /**
+     * Returns the load since the last call.
+     *
+     * @return CPU load in 0.1 %.
+     */
+    uint16_t load()
+    {
+      uint32_t currentSpins = spins;
+      int64_t now = monotonicMicros();
+      uint64_t idleSpins = (uint64_t)baseline * (now - lastTime) / 1000;
+      uint64_t busySpins = currentSpins - lastSpins;
+      lastSpins = currentSpins;
+      lastTime = now;
+
+      if(idleSpins == 0 || busySpins >= idleSpins) return 0;
+      return 1000 - busySpins * 1000 / idleSpins;
+    }
+};
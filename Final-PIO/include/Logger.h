@@ -6,7 +6,9 @@
 
 #pragma once
 #include "config.h"
+#include "SensorSample.h"
 #include <exception>
+#include <stdexcept>
 
 
 /**
@@ -20,7 +22,23 @@
  */
 class Logger{
     public:
-        virtual void log(const std::map<const char*, double>* sensorData) = 0;
+        /**
+         * Publishes a sample.
+         * 
+         * A batching logger may only add the sample to its batch and publish the batch once it's due. The sample is then taken over
+         * even if publishing the batch throws, which the caller can tell by buffered().
+         */
+        virtual void log(const SensorSample& sample) = 0;
+
+        /**
+         * Publishes the batch if it's due (f.e. by its age), or retries a batch that failed to be published.
+         * 
+         * Only throws if publishing was attempted, does nothing for loggers without batching.
+         */
+        virtual void flush() {}
+
+        /** @return number of samples taken over by log(), but not yet acknowledged by the server. */
+        virtual uint16_t buffered() const { return 0; }
 };
 
 /**
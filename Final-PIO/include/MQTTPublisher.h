@@ -0,0 +1,155 @@
+/**
+ * @file MQTTPublisher.h
+ * @author Simon Schimik
+ * @version 3.0
+ */
+
+#pragma once
+
+#include "config.h"
+#include "Logger.h"
+#include "JsonWriter.h"
+
+/**
+ * Base of the MQTT loggers, builds the topics and payloads of a sample.
+ *
+ * How a sample is published depends on MQTT_PUBLISH_MODE, the subclass only provides the transport by publish().
+ */
+class MQTTPublisher : public Logger
+{
+  protected:
+    /** Size of a feed topic, AIOUSERNAME/feeds/<feed><suffix>. */
+    static const size_t TOPIC_SIZE = sizeof(AIOUSERNAME "/feeds/") + 24;
+
+    /** Size of the JSON-object of a sample, which is larger than the packet buffer of Adafruit_MQTT for summaries. */
+    static const size_t PAYLOAD_SIZE = jsonObjectSize(jsonFieldsLength(LOG_SUMMARY));
+
+    char topics[Field::COUNT][Suffix::COUNT][TOPIC_SIZE]; ///< feed topic of every value, built once by the constructor
+    char payload[PAYLOAD_SIZE];                           ///< payload of the single packet publishes, reused for every sample
+
+    /**
+     * Publishes a payload.
+     *
+     * @exception LoggerException Thrown if the packet couldn't be sent
+     */
+    virtual void publish(const char* topic, uint8_t* payload, uint16_t length) = 0;
+
+    /**
+     * Publishes every value to its own feed, one packet per value.
+     */
+    void publishFeeds(const SensorSample& sample)
+    {
+      forEachPublishedValue(sample, LOG_SUMMARY, [&](const FieldDescriptor& field, Suffix::Id suffix, const char* value)
+      {
+        publish(topics[field.id][suffix], (uint8_t*)value, strlen(value));
+      });
+    }
+
+    /**
+     * Publishes all values as one JSON-object within a single packet.
+     */
+    void publishJson(const SensorSample& sample)
+    {
+      static const char topic[] = AIOUSERNAME "/groups/" MQTT_GROUP "/json";
+      JsonWriter json(payload, sizeof(payload));
+      forEachPublishedValue(sample, LOG_SUMMARY, [&](const FieldDescriptor& field, Suffix::Id suffix, const char* value)
+      {
+        json.member(field.feed, SUFFIXES[suffix], value);
+      });
+      json.end();
+      publish(topic, (uint8_t*)payload, json.getLength());
+    }
+
+    /**
+     * Appends a value to a binary payload, in the byte order of the ESP32 (little endian).
+     */
+    template<typename T>
+    static uint8_t* put(uint8_t* position, T value)
+    {
+      memcpy(position, &value, sizeof(value));
+      return position + sizeof(value);
+    }
+
+    /**
+     * Publishes all values in a compact binary layout within a single packet.
+     *
+     * Layout, little endian:
+     * - uint8_t version (1)
+     * - uint8_t summary (0: latest readings, 1: summaries of the reporting window, see LOG_SUMMARY)
+     * - uint32_t timestamp in ms since boot
+     * - uint8_t suspect and uint8_t warming, bit (1 << Field::Id) set for every suspect or warming up field
+     * - per field in the order of Field::Id the int32_t latest reading, or the int32_t mean, min, max and stddev followed by the uint16_t count,
+     *   in fixed point with the decimal places of the field (see FIELDS)
+     *
+     * That's 32 bytes for the latest readings and 116 bytes for the summaries.
+     */
+    void publishBinary(const SensorSample& sample)
+    {
+      static_assert(8 + Field::COUNT * (4 * sizeof(int32_t) + sizeof(uint16_t)) <= PAYLOAD_SIZE, "Binary payload exceeds the payload buffer");
+      uint8_t* position = (uint8_t*)payload;
+      position = put<uint8_t>(position, 1);
+      position = put<uint8_t>(position, LOG_SUMMARY);
+      position = put<uint32_t>(position, sample.timestamp);
+      position = put<uint8_t>(position, sample.suspect);
+      position = put<uint8_t>(position, sample.warming);
+      for(const FieldDescriptor& field : FIELDS)
+      {
+        if(!LOG_SUMMARY)
+        {
+          position = put<int32_t>(position, sample[field.id]);
+          continue;
+        }
+        const FieldSummary& window = sample.summary[field.id];
+        position = put<int32_t>(position, window.mean);
+        position = put<int32_t>(position, window.min);
+        position = put<int32_t>(position, window.max);
+        position = put<int32_t>(position, window.stddev);
+        position = put<uint16_t>(position, window.count);
+      }
+      publish(AIOUSERNAME "/groups/" MQTT_GROUP "/binary", (uint8_t*)payload, position - (uint8_t*)payload);
+    }
+
+    /** Largest number of packets publishSample() publishes for a sample. */
+    static const uint8_t SAMPLE_PACKETS = MQTT_PUBLISH_MODE == MQTT_FEEDS ? publishedValuesMax(LOG_SUMMARY) : 1;
+
+    /** Largest packet publishSample() publishes with QoS 1, a feed value has at most 15 characters (see forEachPublishedValue()). */
+    static const size_t PACKET_SIZE = MQTT_PUBLISH_MODE == MQTT_FEEDS ? 1 + 4 + 2 + TOPIC_SIZE + 2 + 15
+                                                                      : 1 + 4 + 2 + sizeof(AIOUSERNAME "/groups/" MQTT_GROUP "/binary") + 2 + PAYLOAD_SIZE;
+
+    /** @return number of packets publishSample() publishes for the sample. */
+    uint8_t samplePackets(const SensorSample& sample) const
+    {
+      if(MQTT_PUBLISH_MODE != MQTT_FEEDS) return 1;
+      uint8_t packets = 0;
+      forEachPublishedValue(sample, LOG_SUMMARY, [&](const FieldDescriptor&, Suffix::Id, const char*) { packets++; });
+      return packets;
+    }
+
+    /**
+     * Publishes a sample, depending on MQTT_PUBLISH_MODE all values within a single packet or fanned out to one feed per value.
+     *
+     * @exception LoggerException Thrown if publishing failed
+     */
+    void publishSample(const SensorSample& sample)
+    {
+#if MQTT_PUBLISH_MODE == MQTT_GROUP_JSON
+      publishJson(sample);
+#elif MQTT_PUBLISH_MODE == MQTT_BINARY
+      publishBinary(sample);
+#else
+      publishFeeds(sample);
+#endif
+    }
+
+  public:
+    /**
+     * Builds all feed topics, publishing doesn't allocate any memory.
+     */
+    MQTTPublisher()
+    {
+      for(const FieldDescriptor& field : FIELDS)
+      {
+        for(uint8_t suffix = 0; suffix < Suffix::COUNT; suffix++) snprintf(topics[field.id][suffix], TOPIC_SIZE, AIOUSERNAME "/feeds/%s%s", field.feed, SUFFIXES[suffix]);
+      }
+    }
+};
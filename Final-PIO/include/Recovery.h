@@ -0,0 +1,115 @@
+/**
+ * @file Recovery.h
+ * @author Simon Schimik
+ * @version 3.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Supervises one component (a sensor or the logger) and schedules its recovery.
+ *
+ * A component is regarded as down after errorLimit errors in a row or an explicit fail(). While it's down, re-initialising it
+ * is retried with exponential backoff, starting at minBackoffMs and doubling up to maxBackoffMs. Only the failing component is re-initialised,
+ * every other component keeps running. Failures, recoveries and the accumulated downtime are recorded.
+ * All times are ms since boot (millis()).
+ */
+class Recovery
+{
+  private:
+    const char* name;
+    uint8_t errorLimit;
+    uint32_t minBackoffMs;
+    uint32_t maxBackoffMs;
+
+    bool up = true;
+    uint8_t errors = 0;     ///< errors in a row
+    uint32_t backoffMs = 0;
+    uint32_t downSince = 0;
+    uint32_t nextAttempt = 0;
+    uint32_t failures = 0;
+    uint32_t recoveries = 0;
+    uint32_t attempts = 0;  ///< failed recovery attempts
+    uint32_t downtimeMs = 0; ///< downtime of all finished outages
+
+  public:
+    /**
+     * @param name Name of the component.
+     * @param errorLimit Errors in a row after which the component is regarded as down.
+     * @param minBackoffMs Delay of the first recovery attempt.
+     * @param maxBackoffMs Largest delay between two recovery attempts.
+     */
+    Recovery(const char* name, uint8_t errorLimit, uint32_t minBackoffMs, uint32_t maxBackoffMs) :
+      name(name), errorLimit(errorLimit), minBackoffMs(minBackoffMs), maxBackoffMs(maxBackoffMs) {}
+
+    /**
+     * Marks the component as down, the first recovery attempt is due after minBackoffMs.
+     */
+    void fail(uint32_t nowMs)
+    {
+      if(!up) return;
+      up = false;
+      failures++;
+      downSince = nowMs;
+      backoffMs = minBackoffMs;
+      nextAttempt = nowMs + backoffMs;
+    }
+
+    /**
+     * Reports a failed operation, the component is marked as down once errorLimit errors occured in a row.
+     */
+    void reportError(uint32_t nowMs)
+    {
+      if(up && ++errors >= errorLimit) fail(nowMs);
+    }
+
+    /**
+     * Reports a successful operation.
+     */
+    void reportOk()
+    {
+      errors = 0;
+    }
+
+    /** @return true if the component is down and the next recovery attempt is due. */
+    bool retryDue(uint32_t nowMs) const
+    {
+      return !up && (int32_t)(nowMs - nextAttempt) >= 0;
+    }
+
+    /**
+     * Records the result of a recovery attempt.
+     *
+     * @param recovered true if the component has been re-initialised successfully.
+     * @param nowMs Time of the end of the attempt.
+     */
+    void retried(bool recovered, uint32_t nowMs)
+    {
+      if(up) return;
+      if(recovered)
+      {
+        up = true;
+        errors = 0;
+        recoveries++;
+        downtimeMs += nowMs - downSince;
+        return;
+      }
+      attempts++;
+      backoffMs = backoffMs * 2 < maxBackoffMs ? backoffMs * 2 : maxBackoffMs;
+      nextAttempt = nowMs + backoffMs;
+    }
+
+    const char* getName() const { return name; }
+    bool isUp() const { return up; }
+    uint32_t getFailures() const { return failures; }
+    uint32_t getRecoveries() const { return recoveries; }
+    uint32_t getAttempts() const { return attempts; }
+
+    /** @return total downtime in ms, including the current outage. */
+    uint32_t getDowntime(uint32_t nowMs) const
+    {
+      return downtimeMs + (up ? 0 : nowMs - downSince);
+    }
+};
@@ -0,0 +1,68 @@
+/**
+ * @file SampleQueue.h
+ * @author Simon Schimik
+ * @version 3.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "circular_queue/circular_queue.h"
+#include "SensorSample.h"
+
+/**
+ * Lock-free queue passing samples from the acquisition task to exactly one consumer.
+ *
+ * Wraps the single-producer single-consumer circular_queue of EspSoftwareSerial. Every consumer (logger, display) has its own queue,
+ * so a slow consumer can never delay the acquisition task or another consumer. If a queue is full the new sample is dropped for this consumer only.
+ */
+class SampleQueue
+{
+  private:
+    circular_queue<SensorSample> queue;
+    std::atomic<uint32_t> dropped;
+
+  public:
+    SampleQueue(size_t capacity) : queue(capacity) { dropped.store(0); }
+
+    /**
+     * Pushes a sample, must only be called by the producer.
+     *
+     * @return false if the queue was full and the sample was dropped.
+     */
+    bool push(const SensorSample& sample)
+    {
+      if(queue.push(sample)) return true;
+      dropped.fetch_add(1);
+      return false;
+    }
+
+    /**
+     * Pops the oldest sample, must only be called by the consumer.
+     *
+     * @param sample Receives the sample.
+     * @return false if the queue was empty.
+     */
+    bool pop(SensorSample& sample)
+    {
+      if(!queue.available()) return false;
+      sample = queue.pop();
+      return true;
+    }
+
+    /**
+     * Pops all queued samples and keeps only the newest, must only be called by the consumer.
+     *
+     * @param sample Receives the newest sample.
+     * @return false if the queue was empty.
+     */
+    bool popLatest(SensorSample& sample)
+    {
+      bool popped = false;
+      while(pop(sample)) popped = true;
+      return popped;
+    }
+
+    /** @return number of samples dropped because the consumer fell behind. */
+    uint32_t droppedCount() const { return dropped.load(); }
+};
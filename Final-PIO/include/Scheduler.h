@@ -0,0 +1,153 @@
+/**
+ * @file Scheduler.h
+ * @author Simon Schimik
+ * @version 3.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include "esp_timer.h"
+#else
+#include <chrono>
+#endif
+
+/**
+ * Returns the time since boot in microseconds.
+ *
+ * Monotonic, unlike millis() it does not wrap after 49 days. On the ESP32 esp_timer is used, on a host std::chrono::steady_clock.
+ */
+inline int64_t monotonicMicros()
+{
+#ifdef ARDUINO
+  return esp_timer_get_time();
+#else
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * Signature of a job function.
+ */
+typedef void (*JobFunction)();
+
+/**
+ * Scheduling statistics of a single job.
+ *
+ * Lateness is the time between the deadline of a run and the moment it actually started.
+ */
+struct JobStats
+{
+  uint32_t runs = 0;        ///< number of runs
+  uint32_t overruns = 0;    ///< number of deadlines skipped because the job was late by more than a whole period
+  int64_t minLateness = 0;  ///< smallest lateness in us
+  int64_t maxLateness = 0;  ///< largest lateness in us
+  int64_t sumLateness = 0;  ///< sum of all latenesses in us
+
+  /** @return mean lateness in us. */
+  int64_t meanLateness() const { return runs ? sumLateness / runs : 0; }
+
+  /** @return jitter (max - min lateness) in us. */
+  int64_t jitter() const { return maxLateness - minLateness; }
+};
+
+/**
+ * Deadline based multi-rate scheduler.
+ *
+ * Every job has its own period, its deadlines are multiples of the period from the first deadline on.
+ * The next deadline is calculated from the previous deadline and not from the time the job actually ran,
+ * therefore a late run does not shift the following ones and the period does not drift.
+ * Jobs are run by calling run() repeatedly, it never blocks.
+ */
+class Scheduler
+{
+  public:
+    static const uint8_t MAX_JOBS = 8;
+
+  private:
+    struct Job
+    {
+      const char* name;
+      JobFunction function;
+      int64_t period;
+      int64_t deadline;
+      JobStats stats;
+    };
+
+    Job jobs[MAX_JOBS];
+    uint8_t count = 0;
+
+  public:
+    /**
+     * Adds a job.
+     *
+     * @param name Name of the job (for debugging only).
+     * @param function The job function.
+     * @param periodMs Period of the job in ms.
+     * @param offsetMs Time from now until the first run in ms.
+     * @return Index of the job, -1 if MAX_JOBS is exceeded.
+     */
+    int8_t addJob(const char* name, JobFunction function, uint32_t periodMs, uint32_t offsetMs = 0)
+    {
+      if(count >= MAX_JOBS) return -1;
+      Job& job = jobs[count];
+      job.name = name;
+      job.function = function;
+      job.period = (int64_t)periodMs * 1000;
+      job.deadline = monotonicMicros() + (int64_t)offsetMs * 1000;
+      job.stats = JobStats();
+      return count++;
+    }
+
+    /**
+     * Runs all jobs whose deadline has passed.
+     *
+     * @return Time until the next deadline in ms.
+     */
+    uint32_t run()
+    {
+      int64_t now = monotonicMicros();
+      for(uint8_t i = 0; i < count; i++)
+      {
+        Job& job = jobs[i];
+        if(now < job.deadline) continue;
+
+        record(job.stats, now - job.deadline);
+        job.function();
+
+        job.deadline += job.period;
+        now = monotonicMicros();
+        if(job.deadline < now)
+        {
+          // The next deadline has already passed, skip the missed deadlines instead of running the job several times in a row (one that is just due still runs)
+          int64_t missed = (now - job.deadline) / job.period + 1;
+          job.deadline += missed * job.period;
+          job.stats.overruns += missed;
+        }
+      }
+
+      int64_t next = INT64_MAX;
+      for(uint8_t i = 0; i < count; i++) if(jobs[i].deadline < next) next = jobs[i].deadline;
+      return next <= now ? 0 : (next - now + 999) / 1000;
+    }
+
+    /** @return number of jobs. */
+    uint8_t jobCount() const { return count; }
+
+    /** @return name of the job. */
+    const char* getName(uint8_t job) const { return jobs[job].name; }
+
+    /** @return scheduling statistics of the job. */
+    const JobStats& getStats(uint8_t job) const { return jobs[job].stats; }
+
+  private:
+    static void record(JobStats& stats, int64_t lateness)
+    {
+      if(stats.runs == 0 || lateness < stats.minLateness) stats.minLateness = lateness;
+      if(stats.runs == 0 || lateness > stats.maxLateness) stats.maxLateness = lateness;
+      stats.sumLateness += lateness;
+      stats.runs++;
+    }
+};
@@ -0,0 +1,253 @@
+/**
+ * @file SensorSample.h
+ * @author Simon Schimik
+ * @version 3.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include "WindowStats.h"
+
+/**
+ * Fields of a SensorSample.
+ *
+ * The value of a field is used as index into SensorSample::values and FIELDS.
+ */
+namespace Field
+{
+  enum Id : uint8_t
+  {
+    TEMPERATURE,
+    HUMIDITY,
+    PRESSURE,
+    PM10,
+    PM25,
+    CO2,
+    COUNT ///< number of fields, not a field itself
+  };
+}
+
+/**
+ * Describes how a field is named, displayed and published.
+ *
+ * Values are stored in fixed point: the stored integer is the value in unit multiplied by 10^precision,
+ * f.e. temperature in 0.01 C, pressure in Pa (0.01 hPa), PM in 0.1 um_g/m^3 and CO2 in ppm.
+ */
+struct FieldDescriptor
+{
+  Field::Id id;        ///< field described, must match the position in FIELDS
+  const char* name;    ///< name shown on the display
+  const char* unit;    ///< unit shown on the display
+  const char* jsonKey; ///< key used by HTTPLogger
+  const char* feed;    ///< feed name used by MQTTLogger
+  uint8_t precision;   ///< number of fixed point decimal places
+  int32_t noiseFloor;  ///< deviation in fixed point that is regarded as noise by the outlier filter, no matter how steady the signal is
+};
+
+/**
+ * Descriptor table of all fields, indexed by Field::Id.
+ */
+constexpr FieldDescriptor FIELDS[] = {
+  {Field::TEMPERATURE, "Temperature",       "C",        "temperature", "temperature", 2, 50},  // 0.5 C
+  {Field::HUMIDITY,    "Humidity",          "%",        "humidity",    "humidity",    2, 200}, // 2 %
+  {Field::PRESSURE,    "Pressure",          "hPa",      "pressure",    "pressure",    2, 100}, // 1 hPa
+  {Field::PM10,        "PM10",              "um_g/m^3", "pm10",        "pm10",        1, 50},  // 5 um_g/m^3
+  {Field::PM25,        "PM2.5",             "um_g/m^3", "pm25",        "pm25",        1, 50},  // 5 um_g/m^3
+  {Field::CO2,         "CO2-Concentration", "ppm",      "CO2",         "CO2",         0, 50}   // 50 ppm
+};
+
+/**
+ * Checks at compile time that every descriptor is stored at the index of its field.
+ */
+constexpr bool fieldsInOrder(uint8_t i = 0)
+{
+  return i == Field::COUNT || (FIELDS[i].id == i && fieldsInOrder(i + 1));
+}
+
+static_assert(sizeof(FIELDS) / sizeof(FIELDS[0]) == Field::COUNT, "FIELDS must contain one descriptor per field");
+static_assert(fieldsInOrder(), "FIELDS must be ordered like Field::Id");
+
+/**
+ * @return 10^exponent.
+ */
+constexpr int32_t powerOf10(uint8_t exponent)
+{
+  return exponent == 0 ? 1 : 10 * powerOf10(exponent - 1);
+}
+
+/**
+ * @return factor between a value in the unit of the field and its fixed point representation.
+ */
+constexpr int32_t fieldScale(Field::Id field)
+{
+  return powerOf10(FIELDS[field].precision);
+}
+
+/**
+ * Converts a value in the unit of the field to its fixed point representation.
+ *
+ * Only meant for constants (f.e. thresholds), sensor values are converted to fixed point by the drivers already.
+ */
+constexpr int32_t toFixed(Field::Id field, double value)
+{
+  return (int32_t)(value * fieldScale(field) + (value < 0 ? -0.5 : 0.5));
+}
+
+/**
+ * Formats an unsigned integer, without snprintf().
+ *
+ * @param buffer Receives the zero-terminated string, truncated if it doesn't fit.
+ * @param size Size of buffer.
+ * @param value The value.
+ * @param digits Minimum number of digits, padded with leading zeros.
+ * @return Number of characters of the untruncated string (as snprintf()).
+ */
+inline int formatUnsigned(char* buffer, size_t size, uint32_t value, uint8_t digits = 1)
+{
+  char reversed[10];
+  uint8_t length = 0;
+  do
+  {
+    reversed[length++] = '0' + value % 10;
+    value /= 10;
+  }while(value != 0 || length < digits);
+
+  for(uint8_t i = 0; i < length && (size_t)i + 1 < size; i++) buffer[i] = reversed[length - 1 - i];
+  if(size > 0) buffer[length < size ? length : size - 1] = '\0';
+  return length;
+}
+
+/**
+ * Formats a fixed point value with the decimal places of the field, without any floating point operation.
+ *
+ * @param buffer Receives the zero-terminated string.
+ * @param size Size of buffer.
+ * @param field The field of the value.
+ * @param value The fixed point value.
+ * @return Number of characters written (as snprintf()).
+ */
+inline int formatFixed(char* buffer, size_t size, Field::Id field, int32_t value)
+{
+  uint8_t precision = FIELDS[field].precision;
+  int32_t scale = fieldScale(field);
+  uint32_t magnitude = value < 0 ? -(uint32_t)value : value;
+  int length = 0;
+
+  if(value < 0)
+  {
+    length++;
+    if(size > 1)
+    {
+      *buffer++ = '-';
+      size--;
+    }
+  }
+  if(precision == 0) return length + formatUnsigned(buffer, size, magnitude);
+
+  int integer = formatUnsigned(buffer, size, magnitude / scale);
+  length += integer + 1;
+  if((size_t)integer + 1 < size)
+  {
+    buffer[integer] = '.';
+    return length + formatUnsigned(buffer + integer + 1, size - integer - 1, magnitude % scale, precision);
+  }
+  return length + precision;
+}
+
+/**
+ * One set of sensor values, taken at the same time.
+ *
+ * Fixed layout, the fixed point values are accessed by their Field::Id, f.e. sample[Field::CO2].
+ * Besides the latest reading every field carries the summary of all readings of the reporting window.
+ */
+struct SensorSample
+{
+  uint32_t timestamp = 0; ///< millis() when the sample was published
+  int32_t values[Field::COUNT] = {};     ///< latest accepted reading of every field
+  FieldSummary summary[Field::COUNT]; ///< summary of the accepted readings of every field within the reporting window
+  uint8_t suspect = 0;                   ///< bit (1 << Field::Id) set if the latest reading of the field failed or was rejected as outlier
+  uint8_t warming = 0;                   ///< bit (1 << Field::Id) set if the sensor of the field hasn't finished its warm-up
+
+  /** @return true if the latest reading of the field failed or was rejected as outlier. */
+  bool isSuspect(Field::Id field) const { return suspect & (1 << field); }
+
+  /** @return true if the sensor of the field hasn't finished its warm-up. */
+  bool isWarming(Field::Id field) const { return warming & (1 << field); }
+
+  int32_t& operator[](Field::Id field) { return values[field]; }
+  int32_t operator[](Field::Id field) const { return values[field]; }
+};
+
+/**
+ * Suffixes of the keys/feeds of the published values, see forEachPublishedValue().
+ */
+namespace Suffix
+{
+  enum Id : uint8_t
+  {
+    NONE,    ///< latest reading, or mean of the window
+    MINIMUM,
+    MAXIMUM,
+    STDDEV,
+    SAMPLES, ///< number of readings in the window
+    SUSPECT,
+    WARMING,
+    COUNT
+  };
+}
+
+/** Suffix strings, ordered like Suffix::Id. */
+constexpr const char* SUFFIXES[Suffix::COUNT] = {"", "-min", "-max", "-stddev", "-count", "-suspect", "-warming"};
+
+/**
+ * Largest number of values forEachPublishedValue() calls its function for, with every field suspect and warming up.
+ *
+ * @param summary Whether the summary of the reporting window is published.
+ */
+constexpr uint8_t publishedValuesMax(bool summary)
+{
+  return Field::COUNT * (summary ? Suffix::COUNT : Suffix::COUNT - (Suffix::SUSPECT - Suffix::MINIMUM));
+}
+
+/**
+ * Formats every value of a sample that is to be published.
+ *
+ * If summary is false, the latest reading of every field is passed under the suffix "".
+ * Otherwise the mean of the reporting window is passed under the suffix "", min, max, stddev and count under "-min", "-max", "-stddev" and "-count".
+ * If the latest reading of a field is suspect, "1" is passed under the suffix "-suspect" in addition, if its sensor is still warming up "1" under "-warming".
+ * @param sample The sample to be published.
+ * @param summary Publish the window summary instead of the latest reading.
+ * @param function Called as function(const FieldDescriptor& field, Suffix::Id suffix, const char* value) for every value, the suffix string is SUFFIXES[suffix].
+ */
+template<typename Function>
+void forEachPublishedValue(const SensorSample& sample, bool summary, Function function)
+{
+  char value[16];
+  for(const FieldDescriptor& field : FIELDS)
+  {
+    if(!summary)
+    {
+      formatFixed(value, sizeof(value), field.id, sample[field.id]);
+      function(field, Suffix::NONE, value);
+    }
+    else
+    {
+      const FieldSummary& window = sample.summary[field.id];
+      formatFixed(value, sizeof(value), field.id, window.mean);
+      function(field, Suffix::NONE, value);
+      formatFixed(value, sizeof(value), field.id, window.min);
+      function(field, Suffix::MINIMUM, value);
+      formatFixed(value, sizeof(value), field.id, window.max);
+      function(field, Suffix::MAXIMUM, value);
+      formatFixed(value, sizeof(value), field.id, window.stddev);
+      function(field, Suffix::STDDEV, value);
+      formatUnsigned(value, sizeof(value), window.count);
+      function(field, Suffix::SAMPLES, value);
+    }
+
+    if(sample.isSuspect(field.id)) function(field, Suffix::SUSPECT, "1");
+    if(sample.isWarming(field.id)) function(field, Suffix::WARMING, "1");
+  }
+}
@@ -0,0 +1,145 @@
+/**
+ * @file Task.h
+ * @author Simon Schimik
+ * @version 3.0
+ */
+
+#pragma once
+
+#ifdef ARDUINO
+#include "Arduino.h"
+#else
+#include <pthread.h>
+#include <unistd.h>
+#include <stdint.h>
+#endif
+
+/**
+ * Signature of a task function.
+ *
+ * Task functions are not supposed to return, they run an endless loop.
+ */
+typedef void (*TaskFunction)(void* arg);
+
+#ifdef ARDUINO
+
+/**
+ * Starts a task.
+ *
+ * On the ESP32 the task is a FreeRTOS-task pinned to the given core.
+ * @param function The task function.
+ * @param name Name of the task (for debugging only).
+ * @param stackSize Stack size of the task in bytes.
+ * @param arg Argument passed to the task function.
+ * @param priority Priority of the task, loop() runs with priority 1.
+ * @param core Core the task is pinned to (0 = WiFi-core, 1 = loop()-core).
+ * @return true if the task was started successfully.
+ */
+inline bool startTask(TaskFunction function, const char* name, uint32_t stackSize, void* arg, uint8_t priority, uint8_t core)
+{
+  return xTaskCreatePinnedToCore(function, name, stackSize, arg, priority, NULL, core) == pdPASS;
+}
+
+/**
+ * Pauses the calling task without blocking other tasks.
+ *
+ * @param ms Duration in milliseconds.
+ */
+inline void taskDelay(uint32_t ms)
+{
+  vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+/**
+ * Ends the calling task.
+ *
+ * A FreeRTOS-task must never return from its task function, a task function that finishes has to call this instead.
+ */
+inline void endTask()
+{
+  vTaskDelete(NULL);
+}
+
+/**
+ * Mutex guarding peripherals shared between tasks (f.e. the TFT).
+ */
+class Mutex
+{
+  private:
+    SemaphoreHandle_t handle;
+
+  public:
+    Mutex() : handle(xSemaphoreCreateMutex()) {}
+    void lock() { xSemaphoreTake(handle, portMAX_DELAY); }
+    void unlock() { xSemaphoreGive(handle); }
+};
+
+#else
+
+/**
+ * pthread stand-in for the FreeRTOS-task API, allows running the sample pipeline on a host.
+ *
+ * Name, stack size, priority and core are ignored.
+ */
+inline bool startTask(TaskFunction function, const char* /*name*/, uint32_t /*stackSize*/, void* arg, uint8_t /*priority*/, uint8_t /*core*/)
+{
+  struct Start
+  {
+    TaskFunction function;
+    void* arg;
+
+    static void* run(void* start)
+    {
+      Start s = *static_cast<Start*>(start);
+      delete static_cast<Start*>(start);
+      s.function(s.arg);
+      return NULL;
+    }
+  };
+
+  pthread_t thread;
+  Start* start = new Start{function, arg};
+  if(pthread_create(&thread, NULL, &Start::run, start) != 0)
+  {
+    delete start;
+    return false;
+  }
+  pthread_detach(thread);
+  return true;
+}
+
+inline void taskDelay(uint32_t ms)
+{
+  usleep(ms * 1000);
+}
+
+inline void endTask()
+{
+  // the thread ends once the task function returns
+}
+
+class Mutex
+{
+  private:
+    pthread_mutex_t handle;
+
+  public:
+    Mutex() { pthread_mutex_init(&handle, NULL); }
+    void lock() { pthread_mutex_lock(&handle); }
+    void unlock() { pthread_mutex_unlock(&handle); }
+};
+
+#endif
+
+/**
+ * Locks a Mutex for the lifetime of the object.
+ */
+class MutexLock
+{
+  private:
+    Mutex& mutex;
+
+  public:
+    MutexLock(Mutex& mutex) : mutex(mutex) { mutex.lock(); }
+    ~MutexLock() { mutex.unlock(); }
+};
@@ -0,0 +1,94 @@
+/**
+ * @file Warmup.h
+ * @author Simon Schimik
+ * @version 3.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Readiness of a sensor.
+ */
+enum class Readiness : uint8_t
+{
+  WARMING_UP, ///< readings are available, but not yet settled
+  READY,      ///< readings have settled
+  FAILED      ///< readings did not settle within the timeout
+};
+
+/**
+ * Tracks the warm-up of one field of a sensor in the background.
+ *
+ * The field is ready once two valid readings in a row differ by no more than the threshold (like the former blocking preheat loops).
+ * Every reading is only compared to the previous one, no reading is waited for.
+ */
+class Warmup
+{
+  private:
+    Readiness state = Readiness::WARMING_UP;
+    int32_t threshold;
+    uint32_t timeoutMs;
+    uint32_t deadline; ///< time since boot after which a field still warming up is regarded as failed
+    int32_t last = 0;
+    bool hasLast = false;
+
+  public:
+    /**
+     * @param threshold Largest difference (fixed point) between two readings regarded as settled, negative if the field needs no warm-up.
+     * @param timeoutMs Time since boot (or since restart()) after which a field still warming up is regarded as failed.
+     */
+    Warmup(int32_t threshold, uint32_t timeoutMs) : threshold(threshold), timeoutMs(timeoutMs), deadline(timeoutMs)
+    {
+      if(threshold < 0) state = Readiness::READY;
+    }
+
+    /**
+     * Takes a reading into account.
+     *
+     * @param value The fixed point reading.
+     * @param valid false if the reading failed, the comparison then starts over.
+     *
+     * A failed field still becomes ready if its readings settle later on.
+     */
+    void update(int32_t value, bool valid)
+    {
+      if(state == Readiness::READY) return;
+      if(!valid)
+      {
+        hasLast = false;
+        return;
+      }
+      int32_t difference = value > last ? value - last : last - value;
+      if(hasLast && difference <= threshold) state = Readiness::READY;
+      last = value;
+      hasLast = true;
+    }
+
+    /**
+     * Marks the field as failed if it's still warming up after the timeout.
+     *
+     * @param nowMs Time since boot in ms.
+     */
+    void expire(uint32_t nowMs)
+    {
+      if(state == Readiness::WARMING_UP && (int32_t)(nowMs - deadline) >= 0) state = Readiness::FAILED;
+    }
+
+    /**
+     * Starts the warm-up over, f.e. after the sensor has been re-initialised. A field that needs no warm-up stays ready.
+     *
+     * @param nowMs Time since boot in ms, the timeout starts from here.
+     */
+    void restart(uint32_t nowMs)
+    {
+      if(threshold < 0) return;
+      state = Readiness::WARMING_UP;
+      hasLast = false;
+      deadline = nowMs + timeoutMs;
+    }
+
+    Readiness getState() const { return state; }
+    bool isReady() const { return state == Readiness::READY; }
+};
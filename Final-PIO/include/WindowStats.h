@@ -0,0 +1,89 @@
+/**
+ * @file WindowStats.h
+ * @author Simon Schimik
+ * @version 3.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+/**
+ * Statistical summary of the readings of one field within a reporting window.
+ *
+ * All values are fixed point, in the same scale as the readings.
+ */
+struct FieldSummary
+{
+  int32_t mean = 0;
+  int32_t min = 0;
+  int32_t max = 0;
+  int32_t stddev = 0; ///< population standard deviation
+  uint16_t count = 0; ///< number of readings in the window
+};
+
+/**
+ * Incremental statistics over a reporting window.
+ *
+ * Every reading is added once, only count, min, max, sum and sum of squares are kept.
+ * Memory and time per reading are therefore constant, no matter how many readings the window contains.
+ */
+class WindowStats
+{
+  private:
+    uint16_t count = 0;
+    int32_t min = 0;
+    int32_t max = 0;
+    int64_t sum = 0;
+    int64_t sumSquares = 0;
+
+  public:
+    /**
+     * Adds a reading to the window.
+     *
+     * @param value The fixed point reading.
+     */
+    void add(int32_t value)
+    {
+      if(count == 0 || value < min) min = value;
+      if(count == 0 || value > max) max = value;
+      sum += value;
+      sumSquares += (int64_t)value * value;
+      count++;
+    }
+
+    /**
+     * Starts a new window.
+     */
+    void reset()
+    {
+      count = 0;
+      sum = 0;
+      sumSquares = 0;
+    }
+
+    /** @return number of readings in the window. */
+    uint16_t size() const { return count; }
+
+    /**
+     * Summarises the window.
+     *
+     * @return The summary, all zero if the window is empty.
+     */
+    FieldSummary summary() const
+    {
+      FieldSummary summary;
+      if(count == 0) return summary;
+
+      summary.count = count;
+      summary.min = min;
+      summary.max = max;
+      summary.mean = (sum + (sum < 0 ? -count / 2 : count / 2)) / count;
+
+      // n^2 * variance, calculated in integer to avoid cancellation, only the square root is done in float
+      int64_t scaledVariance = (int64_t)count * sumSquares - sum * sum;
+      summary.stddev = scaledVariance > 0 ? (int32_t)(sqrtf((float)scaledVariance) / count + 0.5f) : 0;
+      return summary;
+    }
+};
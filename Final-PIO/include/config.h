@@ -5,12 +5,11 @@
  * @version 3.0
  */
 
+// Only the settings are needed by the host tests (see env:native)
+#ifdef ARDUINO
 // Arduino Core-libraries
 #include "Arduino.h"
 
-// C++-Standard-libraries
-#include <map>
-
 // TFT-Libraries
 #include <Adafruit_GFX.h>    // Core graphics library
 #include <Adafruit_ST7735.h> // Hardware-specific library for ST7735
@@ -29,6 +28,7 @@
 
 // Connectivity
 #include <WiFi.h>
+#endif
 
 // TFT-Pins
 #define TFT_CS 5 
@@ -39,23 +39,133 @@
 #define SDS_RX 25
 #define SDS_TX 26
 
+/**
+ * Defines whether the SDS011 is connected through hardware UART 2 instead of SoftwareSerial.
+ * 
+ * The UART is mapped to SDS_RX and SDS_TX, no rewiring is needed. SoftwareSerial samples every edge in an ISR and decodes the bits in software,
+ * the hardware UART only interrupts once its FIFO has to be emptied.
+ */
+#define SDS_HARDWARE_SERIAL false
+
+/**
+ * Defines whether the cost of the SDS011-transport is measured.
+ * 
+ * If true, the CPU load of core 1 (where the acquisition and the serial ISRs run) is printed to Serial every LOOPDELAY ms.
+ * With SoftwareSerial the ISR count, ISR time and decode time are printed as well, the ISR of the hardware UART belongs to ESP-IDF and is only covered by the CPU load.
+ * Set in build_flags of platformio.ini, as it also compiles the counters into the SoftwareSerial ISRs (SWSERIAL_RX_STATS), which are left out otherwise.
+ */
+#ifndef SDS_MEASURE_TRANSPORT
+#define SDS_MEASURE_TRANSPORT false
+#endif
+
 // MH-Z19C-Pins
 #define MH_TX 32
 #define MH_RX 33
 
+// HardwareSerial::onReceive() is only available from arduino-esp32 2.0.0 onwards
+#if defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 2
+#define MH_ONRECEIVE
+#endif
+
 #define SSID ""
 #define PASS ""
 
+/** Defines the logger the samples are published to: HTTPLogger, MQTTLogger or AsyncMQTTLogger. */
+#define LOGGER HTTPLogger
+
 // MQTTLogger
 #define AIOSERVER "0.0.0.0"
 #define AIOSERVERPORT 1883
 #define AIOUSERNAME ""
 #define AIOKEY ""
+
+// Publish modes of the MQTTLogger, see MQTT_PUBLISH_MODE
+#define MQTT_FEEDS 0      ///< every value to its own feed AIOUSERNAME/feeds/<feed>, one packet per value
+#define MQTT_GROUP_JSON 1 ///< all values to AIOUSERNAME/groups/MQTT_GROUP/json as JSON-object {"<feed>":"<value>",...}, like Adafruit IO group publishes
+#define MQTT_BINARY 2     ///< all values to AIOUSERNAME/groups/MQTT_GROUP/binary in the compact binary layout of MQTTLogger
+
+/**
+ * Defines how the MQTTLogger publishes a sample.
+ * 
+ * MQTT_GROUP_JSON and MQTT_BINARY publish all values of a sample within a single packet, MQTT_FEEDS fans them out to one feed per value.
+ */
+#define MQTT_PUBLISH_MODE MQTT_GROUP_JSON
+
+/** Defines the group the MQTTLogger publishes to in MQTT_GROUP_JSON and MQTT_BINARY mode. */
+#define MQTT_GROUP "sensors"
+
+/**
+ * Defines the QoS level (0 or 1) of the MQTTLogger publishes.
+ * 
+ * With QoS 1 all packets of a sample are sent without waiting, the PUBACKs are awaited once for the whole sample (see Adafruit_MQTT::publishPipelined()).
+ */
+#define MQTT_QOS 1
+
+/** Defines how long in ms the MQTTLogger waits for the PUBACKs of a sample before the sample is regarded as failed and retried. */
+#define MQTT_ACK_TIMEOUT 5000
+
+/**
+ * Defines how many samples the outbound queue of the AsyncMQTTLogger holds, queued ones and QoS 1 packets awaiting their PUBACK.
+ * 
+ * The queue is sized from FIELDS and the suffixes for the packets of MQTT_FEEDS mode, a slot takes the largest packet of the publish mode
+ * (a JSON-object of summaries, see LOG_SUMMARY, takes about 1.1 kB).
+ */
+#define MQTT_ASYNC_QUEUE_SAMPLES 4
+
+/** Defines the keep-alive interval of the AsyncMQTTLogger in s, a PINGREQ is sent once nothing was sent for half of it. */
+#define MQTT_ASYNC_KEEPALIVE 60
+
+/** Defines how long in ms the AsyncMQTTLogger waits for the broker to accept a connection (CONNACK) before it's closed. */
+#define MQTT_ASYNC_CONNECT_TIMEOUT 10000
+
+/** Defines the period in ms in which the sensor values are published to the logger and the display. */
 #define LOOPDELAY 15000
 
 // HTTPLogger
 #define HTTPSERVER ""
 
+/**
+ * Defines how many samples the HTTPLogger posts within one request.
+ * 
+ * If 1, every sample is posted as single JSON-object as soon as it's logged. Otherwise the samples are collected and posted as JSON-array
+ * (or NDJSON, see HTTP_BATCH_NDJSON), every object carries its sequence number "seq" so the acknowledgement of the request maps back to the single samples.
+ */
+#define HTTP_BATCH_SIZE 1
+
+/** Defines the age in ms of the oldest sample after which a batch is posted even if it holds less than HTTP_BATCH_SIZE samples. */
+#define HTTP_BATCH_AGE 60000
+
+/** Defines whether a batch is posted as NDJSON (one object per line) instead of a JSON-array. */
+#define HTTP_BATCH_NDJSON false
+
+/** Defines how many batches the HTTPLogger queues while a request is in progress or failed, further samples stay with the logger task. */
+#define HTTP_QUEUE_SIZE 4
+
+/** Defines how long in ms a request of the HTTPLogger may take (connect, send and response) before it's regarded as failed and retried. */
+#define HTTP_TIMEOUT 5000
+
+/**
+ * Defines whether the loggers publish the summary of the reporting window instead of the latest reading.
+ * 
+ * If true, the mean of the window is published under the regular key/feed, min, max, stddev and count under the key/feed suffixed by -min, -max, -stddev and -count.
+ */
+#define LOG_SUMMARY false
+
+/** Defines how many samples can be queued for each consumer (logger, display) before new samples are dropped. */
+#define SAMPLE_QUEUE_SIZE 16
+
+/** Defines the stack size of the acquisition task in bytes. */
+#define ACQUISITION_STACK_SIZE 4096
+
+/** Defines the stack size of the recovery task in bytes, it runs the blocking re-initialisation of failed sensors. */
+#define RECOVERY_STACK_SIZE 4096
+
+/** Defines the stack size of the logger task in bytes (HTTPClient and MQTT-client need considerably more than the acquisition). */
+#define LOGGER_STACK_SIZE 8192
+
+/** Defines the stack size of every boot stage task in bytes (the WiFi- and OTA-stages need more than the sensor stages). */
+#define BOOT_STAGE_STACK_SIZE 4096
+
 /** Defines limit for the WiFi-reconnect-count until ESP reset.*/
 #define WIFI_CONNECT_LIMIT 30
 
@@ -65,13 +175,80 @@
 /**
  * Defines a threshold for SDS011-sensor values variation during preheating.
  * 
- * SDS011-Preheating will only succeed once two sensor readings taken after another do not vary by more than this amount.
+ * The SDS011 is regarded as warmed up once two sensor readings taken after another do not vary by more than this amount.
  */
 #define SDS_PREHEAT_THRESHOLD 0.5
 
 /**
  * Defines a threshold for MHZ-19C-sensor values variation during preheating.
  * 
- * MHZ-19C-Preheating will only succeed once two sensor readings taken after another do not vary by more than this amount.
+ * The MHZ-19C is regarded as warmed up once two sensor readings taken after another do not vary by more than this amount.
+ */
+#define MH_PREHEAT_THRESHOLD 10
+
+/** Defines the time since boot (or since its re-initialisation) in ms after which a SDS011 still warming up is regarded as failed. */
+#define SDS_WARMUP_TIMEOUT 120000
+
+/** Defines the time since boot (or since its re-initialisation) in ms after which a MH-Z19C still warming up is regarded as failed. */
+#define MH_WARMUP_TIMEOUT 70000
+
+/**
+ * Defines how many ms before the sensor values are published the SDS011-query is issued.
+ * 
+ * The SDS011 needs about 500ms to answer a query. The query is sent asynchronously ahead of time, so the response is already available once the sensor values are published.
+ */
+#define SDS_QUERY_LEAD 1500
+
+/**
+ * Defines how many ms before the sensor values are published the MH-Z19C-request is sent.
+ * 
+ * The response is assembled in the background by the event driven reader of the MH-Z19-library, the request only has to be sent early enough to be answered.
+ */
+#define MH_QUERY_LEAD 500
+
+/** Defines the period of the BME280-readings in ms, every reading within LOOPDELAY is added to the window statistics. */
+#define BME_INTERVAL 1000
+
+/** Defines the period of the MH-Z19C-requests in ms, should be a divisor of LOOPDELAY so a fresh value is available when publishing. */
+#define MH_INTERVAL 2500
+
+/** Defines the period of the SDS011-queries in ms, not used if SDS_ACTIVE_REPORTING is true. */
+#define SDS_INTERVAL LOOPDELAY
+
+/**
+ * Defines whether the SDS011 is operated in active reporting mode.
+ * 
+ * The mode is set by initSDS() right away, the streamed values also drive the warm-up (see Warmup).
+ * In active reporting mode the SDS011 sends its values every second on its own, they are consumed without any command on the wire.
+ * Otherwise the SDS011 is queried every SDS_INTERVAL ms.
  */
-#define MH_PREHEAT_THRESHOLD 10
\ No newline at end of file
+#define SDS_ACTIVE_REPORTING true
+
+/** Defines how many previous readings of a field the outlier filter takes the median of. */
+#define OUTLIER_WINDOW 7
+
+/**
+ * Defines how far a reading may deviate from the median before it's rejected as outlier.
+ * 
+ * The deviation is given in multiples of the running mean deviation of the field, but at least of its noiseFloor (see FIELDS).
+ */
+#define OUTLIER_THRESHOLD 3
+
+/** Defines how often (ms) the acquisition task consumes sensor responses between the scheduled jobs. */
+#define SENSOR_POLL_INTERVAL 5
+
+/** Defines how often (ms) the acquisition task checks the sensors and has failed ones re-initialised by the recovery task. */
+#define RECOVERY_INTERVAL 1000
+
+/** Defines after how many errors in a row (failed readings, missing responses) a sensor is regarded as failed and re-initialised. */
+#define RECOVERY_ERROR_LIMIT 3
+
+/**
+ * Defines the delay in ms of the first attempt to recover a failed sensor or logger.
+ * 
+ * Every further attempt doubles the delay up to RECOVERY_MAX_BACKOFF. Only the failed component is re-initialised, instead of restarting the ESP32.
+ */
+#define RECOVERY_MIN_BACKOFF 1000
+
+/** Defines the largest delay in ms between two attempts to recover a failed sensor or logger. */
+#define RECOVERY_MAX_BACKOFF 60000
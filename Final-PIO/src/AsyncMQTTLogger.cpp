@@ -0,0 +1,85 @@
+/**
+ * @file AsyncMQTTLogger.cpp
+ * @author Simon Schimik
+ * @version 3.0
+ */
+
+#include "Arduino.h"
+#include "config.h"
+#include "Logger.h"
+#include "MQTTPublisher.h"
+#include "AsyncMQTTClient.h"
+
+/**
+ * AsyncMQTTLogger class implementing Logger interface
+ *
+ * Publishes like MQTTLogger, but over the non-blocking AsyncMQTTClient: log() only queues the packets of the sample and returns at once,
+ * sending them and awaiting their PUBACKs happens in the background.
+ */
+class AsyncMQTTLogger : public MQTTPublisher
+{
+  private:
+    /** The outbound queue holds MQTT_ASYNC_QUEUE_SAMPLES samples, every slot takes the largest packet of the publish mode. */
+    typedef AsyncMQTTClient<PACKET_SIZE, MQTT_ASYNC_QUEUE_SAMPLES * SAMPLE_PACKETS> Client;
+
+    Client mqttClient;
+
+    /**
+     * Starts connecting to the MQTT-Broker, if not already connected or connecting
+     *
+     * @exception WiFiNotConnectedException Thrown if no WiFi connection available
+     * @exception LoggerException Thrown if connecting couldn't be started
+     */
+    void connectMQTT()
+    {
+      if(WiFi.status() != WL_CONNECTED) throw WifiNotConnectedException("WiFi not connected!");
+      if(!mqttClient.connect()) throw LoggerException("Broker connection fail!", -1);
+    }
+
+    /**
+     * Queues a payload.
+     *
+     * @exception LoggerException Thrown if the outbound queue is full
+     */
+    void publish(const char* topic, uint8_t* payload, uint16_t length)
+    {
+      if(!mqttClient.publish(topic, payload, length, MQTT_QOS)) throw LoggerException("Outbound queue full!", -1);
+    }
+
+  public:
+    /**
+     * Initialises AsyncMQTTLogger, the broker is connected by the first log().
+     */
+    AsyncMQTTLogger() : mqttClient(AIOSERVER, AIOSERVERPORT, "", AIOUSERNAME, AIOKEY, MQTT_ASYNC_KEEPALIVE) {}
+
+    /**
+     * Queues the current sensor values, doesn't wait for the connection or the broker.
+     *
+     * The sample is queued as a whole or not at all, so a sample is never taken over partly.
+     * @exception WiFiNotConnectedException Thrown if no WiFi connection available
+     * @exception LoggerException Thrown if connecting couldn't be started or the outbound queue can't take all packets of the sample
+     * @param sample the sensor values to be published
+     */
+    void log(const SensorSample& sample)
+    {
+      connectMQTT();
+      if(mqttClient.available() < samplePackets(sample)) throw LoggerException("Outbound queue full!", -1);
+      publishSample(sample);
+    }
+
+    /**
+     * Reconnects if the connection was lost while packets are queued.
+     *
+     * @exception WiFiNotConnectedException Thrown if no WiFi connection available
+     * @exception LoggerException Thrown if the broker isn't connected, the queued packets are sent once it is (retried with backoff by the logger task)
+     */
+    void flush()
+    {
+      if(mqttClient.queued() == 0 || mqttClient.getState() != Client::State::DISCONNECTED) return;
+      connectMQTT();
+      throw LoggerException("Broker not connected!", -1);
+    }
+
+    /** @return number of packets queued or awaiting their PUBACK. */
+    uint16_t buffered() const { return mqttClient.queued(); }
+};
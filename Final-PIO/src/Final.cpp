@@ -7,36 +7,104 @@
 #include "Arduino.h" 
 #include "config.h"
 #include "Logger.h"
+#include "Task.h"
+#include "SampleQueue.h"
+#include "Scheduler.h"
+#include "WindowStats.h"
+#include "HampelFilter.h"
+#include "Warmup.h"
+#include "LoadMeter.h"
+#include "Boot.h"
+#include "Recovery.h"
 #include "MQTTLogger.cpp"
+#include "AsyncMQTTLogger.cpp"
 #include "HTTPLogger.cpp"
 
+#include <atomic>
 #include <AsyncTCP.h>
 #include <ESPAsyncWebServer.h>
 #include <AsyncElegantOTA.h>
 
 AsyncWebServer server(80); 
 Adafruit_ST7735 tft(TFT_CS, TFT_DC, TFT_RST);
-SdsDustSensor sds(SDS_RX, SDS_TX);
+#if SDS_HARDWARE_SERIAL
+HardwareSerial sdsSerial(2); // Use UART channel 2
+#else
+SoftwareSerial sdsSerial(SDS_RX, SDS_TX);
+#endif
+SdsDustSensor sds(sdsSerial);
 MHZ19 myMHZ19;                                            
 HardwareSerial mhSerial(1); // Use UART channel 1  
 Adafruit_BME280 bme;
 Logger* logger;
-uint32_t timer;
+Mutex tftMutex; // The TFT is used by loop() (regular display) and loggerTask() (error display)
 
-/**
- * std::map containing sensor values.
- * 
- * std::map containing sensor values, the keys for the respective sensor values are reused as feed names for MQTTLogger.
- */
-std::map<const char*, double>* sensorData  = new std::map<const char*, double>{
-  {"temperature", 0.0},
-  {"humidity", 0.0},
-  {"pressure", 0.0},
-  {"pm10", 0.0},
-  {"pm25", 0.0},
-  {"CO2", 0.0}
+/** Samples consumed by loggerTask(). */
+SampleQueue loggerQueue(SAMPLE_QUEUE_SIZE);
+
+/** Samples consumed by loop() for the display. */
+SampleQueue displayQueue(SAMPLE_QUEUE_SIZE);
+
+/** Runs the sensor jobs of acquisitionTask(), each sensor at its own rate. */
+Scheduler scheduler;
+
+/** Latest values of all sensors, updated by the sensor jobs and published by publishSample(). Only used by acquisitionTask(). */
+SensorSample current;
+
+/** Statistics of the accepted readings of every field within the current reporting window. Only used by acquisitionTask(). */
+WindowStats window[Field::COUNT];
+
+/** Outlier filter of every field. Only used by acquisitionTask(). */
+HampelFilter<OUTLIER_WINDOW> outlierFilter[Field::COUNT];
+
+/** Background warm-up of every field, ordered like Field::Id. Only used by acquisitionTask(). */
+Warmup warmup[Field::COUNT] = {
+  Warmup(-1, 0), // temperature, the BME280 needs no warm-up
+  Warmup(-1, 0), // humidity
+  Warmup(-1, 0), // pressure
+  Warmup(toFixed(Field::PM10, SDS_PREHEAT_THRESHOLD), SDS_WARMUP_TIMEOUT),
+  Warmup(toFixed(Field::PM25, SDS_PREHEAT_THRESHOLD), SDS_WARMUP_TIMEOUT),
+  Warmup(toFixed(Field::CO2, MH_PREHEAT_THRESHOLD), MH_WARMUP_TIMEOUT)
 };
 
+/** Set while a MH-Z19C-request is waiting for its response. Only used by acquisitionTask(). */
+bool co2Requested = false;
+
+/** Recovery of every sensor, set by the boot stages and afterwards only used by acquisitionTask(). */
+Recovery sdsRecovery("sds011", RECOVERY_ERROR_LIMIT, RECOVERY_MIN_BACKOFF, RECOVERY_MAX_BACKOFF);
+Recovery mhRecovery("mhz19", RECOVERY_ERROR_LIMIT, RECOVERY_MIN_BACKOFF, RECOVERY_MAX_BACKOFF);
+Recovery bmeRecovery("bme280", RECOVERY_ERROR_LIMIT, RECOVERY_MIN_BACKOFF, RECOVERY_MAX_BACKOFF);
+
+/** Recovery of the logger, only used by loggerTask(). Every failed sample fails the logger at once. */
+Recovery loggerRecovery("logger", 1, RECOVERY_MIN_BACKOFF, RECOVERY_MAX_BACKOFF);
+
+#if SDS_ACTIVE_REPORTING
+/** Streamed SDS011-frames at the last check of superviseSensors(). Only used by acquisitionTask(). */
+unsigned long sdsFrames = 0;
+#endif
+
+#if SDS_MEASURE_TRANSPORT
+/** Measures the CPU load of core 1 to compare the cost of the SDS011-transports. */
+LoadMeter loadMeter;
+
+/**
+ * Prints the cost of the SDS011-transport since the last call.
+ */
+void printTransportCost()
+{
+  uint16_t load = loadMeter.load();
+#if SDS_HARDWARE_SERIAL
+  Serial.printf("SDS011 transport: HardwareSerial, core 1 load %u.%u%%\n", load / 10, load % 10);
+#else
+  SoftwareSerial::RxStats stats = sdsSerial.rxStats();
+  sdsSerial.resetRxStats();
+  uint32_t cyclesPerUs = ESP.getCpuFreqMHz();
+  Serial.printf("SDS011 transport: SoftwareSerial, core 1 load %u.%u%%, %u ISRs, ISR %uus, decode %uus\n", load / 10, load % 10,
+                stats.isrCount, stats.isrCycles / cyclesPerUs, stats.decodeCycles / cyclesPerUs);
+#endif
+}
+#endif
+
 /**
  * Initialises OTA-Server.
  * 
@@ -98,16 +166,16 @@ void drawCenteredText(String text, uint8_t x, uint8_t y)
  * Returns a color based on the parameter pm10.
  * 
  * Returns a color for better visualisation on the display of the pm10 value.
- * @param pm10 The pm10 value.
+ * @param pm10 The pm10 value in fixed point.
  * @return Returns a 16-bit hexadecimal representation of the corrosponding color.
  */
-uint16_t getPm10Color(double pm10)
+uint16_t getPm10Color(int32_t pm10)
 {
-  if(pm10 <= 50) return ST7735_CYAN;
-  else if(pm10 <= 100) return ST7735_GREEN;
-  else if(pm10 <= 250) return ST7735_YELLOW;
-  else if(pm10 <= 350) return ST7735_ORANGE;
-  else if(pm10 <= 430) return ST7735_RED;
+  if(pm10 <= toFixed(Field::PM10, 50)) return ST7735_CYAN;
+  else if(pm10 <= toFixed(Field::PM10, 100)) return ST7735_GREEN;
+  else if(pm10 <= toFixed(Field::PM10, 250)) return ST7735_YELLOW;
+  else if(pm10 <= toFixed(Field::PM10, 350)) return ST7735_ORANGE;
+  else if(pm10 <= toFixed(Field::PM10, 430)) return ST7735_RED;
   else return ST7735_PURPLE;
 }
 
@@ -115,16 +183,16 @@ uint16_t getPm10Color(double pm10)
  * Returns a color based on the parameter pm25.
  * 
  * Returns a color for better visualisation on the display of the pm2.5 value.
- * @param pm25 The pm2.5 value.
+ * @param pm25 The pm2.5 value in fixed point.
  * @return Returns a 16-bit hexadecimal representation of the corrosponding color.
  */
-uint16_t getPm25Color(double pm25)
+uint16_t getPm25Color(int32_t pm25)
 {
-  if(pm25 <= 30) return ST7735_CYAN;
-  else if(pm25 <= 60) return ST7735_GREEN;
-  else if(pm25 <= 90) return ST7735_YELLOW;
-  else if(pm25 <= 120) return ST7735_ORANGE;
-  else if(pm25 <= 250) return ST7735_RED;
+  if(pm25 <= toFixed(Field::PM25, 30)) return ST7735_CYAN;
+  else if(pm25 <= toFixed(Field::PM25, 60)) return ST7735_GREEN;
+  else if(pm25 <= toFixed(Field::PM25, 90)) return ST7735_YELLOW;
+  else if(pm25 <= toFixed(Field::PM25, 120)) return ST7735_ORANGE;
+  else if(pm25 <= toFixed(Field::PM25, 250)) return ST7735_RED;
   else return ST7735_PURPLE;
 }
 
@@ -132,26 +200,43 @@ uint16_t getPm25Color(double pm25)
  * Returns a color based on the parameter co2.
  * 
  * Returns a color for better visualisation on the display of the co2 value.
- * @param co2 The co2 value.
+ * @param co2 The co2 value in fixed point.
  * @return Returns a 16-bit hexadecimal representation of the corrosponding color.
  */
-uint16_t getCO2Color(double co2)
+uint16_t getCO2Color(int32_t co2)
 {
-  if(co2 <= 650) return ST7735_CYAN;
-  else if(co2 <= 950) return ST7735_GREEN;
-  else if(co2 <= 1250) return ST7735_YELLOW;
-  else if(co2 <= 1500) return ST7735_ORANGE;
-  else if(co2 <= 1850) return ST7735_RED;
+  if(co2 <= toFixed(Field::CO2, 650)) return ST7735_CYAN;
+  else if(co2 <= toFixed(Field::CO2, 950)) return ST7735_GREEN;
+  else if(co2 <= toFixed(Field::CO2, 1250)) return ST7735_YELLOW;
+  else if(co2 <= toFixed(Field::CO2, 1500)) return ST7735_ORANGE;
+  else if(co2 <= toFixed(Field::CO2, 1850)) return ST7735_RED;
   else return ST7735_PURPLE;
 }
 
+/**
+ * Formats a sensor value.
+ * 
+ * @param sample The sample containing the value.
+ * @param field The field to be formatted, its precision is taken from FIELDS.
+ * @return The value with the number of decimal places of the field.
+ */
+String formatField(const SensorSample& sample, Field::Id field)
+{
+  char buffer[16];
+  formatFixed(buffer, sizeof(buffer), field, sample[field]);
+  return String(buffer);
+}
+
 /**
  * Prints the regular UI and sensor values.
  * 
- * Prints the current sensor values stores in field std::map<const char*, double>* sensorData.
+ * Prints the sensor values of the passed sample.
+ * @param sample The sample to be printed.
  */
-void printRegularDisplay()
+void printRegularDisplay(const SensorSample& sample)
 {
+  MutexLock lock(tftMutex);
+
   // Clear screen
   tft.fillScreen(ST7735_BLACK);
   
@@ -169,30 +254,30 @@ void printRegularDisplay()
   // Draw headers
   tft.setTextSize(1);
   tft.setTextColor(ST7735_WHITE);
-  drawCenteredText("Temperature", tft.width(), 5);
-  drawCenteredText("Humidity", tft.width(), 25);
-  drawCenteredText("Pressure", tft.width(), 45);
-  drawCenteredText("CO2-Concentration", tft.width(), tft.height()*5/12 + 2);
-  drawCenteredText("ppm", tft.width(), tft.height()*5/12 + 30);
-  drawCenteredText("PM10", tft.width()/2+2, tft.height()*2/3+2);
-  drawCenteredText("PM2.5", tft.width()*3/2+2, tft.height()*2/3+2);
-  drawCenteredText("um_g/m^3", tft.width() / 2, tft.height()*2/3+43);
-  drawCenteredText("um_g/m^3", tft.width() * 3/2, tft.height()*2/3+43);
+  drawCenteredText(FIELDS[Field::TEMPERATURE].name, tft.width(), 5);
+  drawCenteredText(FIELDS[Field::HUMIDITY].name, tft.width(), 25);
+  drawCenteredText(FIELDS[Field::PRESSURE].name, tft.width(), 45);
+  drawCenteredText(FIELDS[Field::CO2].name, tft.width(), tft.height()*5/12 + 2);
+  drawCenteredText(FIELDS[Field::CO2].unit, tft.width(), tft.height()*5/12 + 30);
+  drawCenteredText(FIELDS[Field::PM10].name, tft.width()/2+2, tft.height()*2/3+2);
+  drawCenteredText(FIELDS[Field::PM25].name, tft.width()*3/2+2, tft.height()*2/3+2);
+  drawCenteredText(FIELDS[Field::PM10].unit, tft.width() / 2, tft.height()*2/3+43);
+  drawCenteredText(FIELDS[Field::PM25].unit, tft.width() * 3/2, tft.height()*2/3+43);
 
   // Draw sensor values
   tft.setTextSize(1);
   tft.setTextColor(ST7735_BLUE);
-  drawCenteredText(String(sensorData->at("temperature")) + " C", tft.width(), 15);
-  drawCenteredText(String(sensorData->at("humidity")) + " %", tft.width(), 35);
-  drawCenteredText(String(sensorData->at("pressure")) + " hPa", tft.width(), 55);
+  drawCenteredText(formatField(sample, Field::TEMPERATURE) + " " + FIELDS[Field::TEMPERATURE].unit, tft.width(), 15);
+  drawCenteredText(formatField(sample, Field::HUMIDITY) + " " + FIELDS[Field::HUMIDITY].unit, tft.width(), 35);
+  drawCenteredText(formatField(sample, Field::PRESSURE) + " " + FIELDS[Field::PRESSURE].unit, tft.width(), 55);
 
   tft.setTextSize(2);
-  tft.setTextColor(getCO2Color(sensorData->at("CO2")));
-  drawCenteredText(String((int)sensorData->at("CO2")), tft.width(), tft.height()*5/12 + 13);
-  tft.setTextColor(getPm10Color(sensorData->at("pm10")));
-  drawCenteredText(String(sensorData->at("pm10")), tft.width() / 2, tft.height()*2/3+17);
-  tft.setTextColor(getPm25Color(sensorData->at("pm25")));
-  drawCenteredText(String(sensorData->at("pm25")), tft.width() * 3/2, tft.height()*2/3+17);
+  tft.setTextColor(getCO2Color(sample[Field::CO2]));
+  drawCenteredText(formatField(sample, Field::CO2), tft.width(), tft.height()*5/12 + 13);
+  tft.setTextColor(getPm10Color(sample[Field::PM10]));
+  drawCenteredText(formatField(sample, Field::PM10), tft.width() / 2, tft.height()*2/3+17);
+  tft.setTextColor(getPm25Color(sample[Field::PM25]));
+  drawCenteredText(formatField(sample, Field::PM25), tft.width() * 3/2, tft.height()*2/3+17);
 }
 
 /**
@@ -204,6 +289,7 @@ void printRegularDisplay()
  */
 void printDebugDisplay(std::array<String, 8> data, uint16_t primaryColor)
 {
+  MutexLock lock(tftMutex);
   tft.fillScreen(ST7735_BLACK);
   tft.setTextSize(1);
   tft.setTextColor(primaryColor);
@@ -213,65 +299,37 @@ void printDebugDisplay(std::array<String, 8> data, uint16_t primaryColor)
   }
 }
 
-/**
- * Reads sensor values.
- * 
- * Reads sensors and assigns the retrieved values to the corresponding pairs in std::map<const char*.
- */
-void readSensors()
-{
-  PmResult sds_results = sds.queryPm();
-  if (sds_results.isOk()){
-    sensorData->at("pm25") = sds_results.pm25;
-    sensorData->at("pm10") = sds_results.pm10;
-  } else {
-    sensorData->at("pm25") = -1;
-    sensorData->at("pm10") = -1;
-  }
-  
-  sensorData->at("CO2") = myMHZ19.getCO2();
-  sensorData->at("temperature") = bme.readTemperature();
-  sensorData->at("humidity") = bme.readHumidity();
-  sensorData->at("pressure") = bme.readPressure() / 100.0;
-  
-}
-
 /**
  * Initialises the SDS011 sensor.
  * 
- * Initialises the SDS011 sensor, retrieves firmware and preheats the sensor .
+ * Initialises the SDS011 sensor and retrieves firmware. The sensor is preheated in the background by the acquisition task (see Warmup).
+ * Called by the boot stage and by recoveryTask() to recover the sensor, therefore it reports failures to Serial only.
+ * The SDS011 keeps its reporting mode over a reboot, PM frames it still streams while the commands are answered are skipped by the library.
  * 
  * @return true if initialisation was successfull.
  * @return false if communication with sensor failed at any point during initialisation.
  */
 bool initSDS()
 {
-  printDebugDisplay({"Initialising SDS011"}, ST7735_WHITE);
+#if SDS_HARDWARE_SERIAL
+  sdsSerial.begin(9600, SERIAL_8N1, SDS_RX, SDS_TX); // sds.begin() would use the default pins of UART 2, which are used by the TFT
+#else
   sds.begin();
+#endif
 
   if(!sds.queryFirmwareVersion().isOk() || !sds.setQueryReportingMode().isOk() || !sds.wakeup().isOk())
   {
-    printDebugDisplay({"Initialising SDS011", "Initialisation failed", "Restarting in 10s"}, ST7735_RED);
-    delay(10000);
+    log_e("SDS011 initialisation failed");
     return false;
   }
 
-  PmResult last = sds.queryPm();
-  PmResult curr = sds.queryPm();
-  if(!last.isOk() || !curr.isOk())
+#if SDS_ACTIVE_REPORTING
+  if(!sds.beginStream().isOk())
   {
-    printDebugDisplay({"Initialising SDS011", "Failed to retrieve values", "Restarting in 10s"}, ST7735_RED);
-    delay(10000);
+    log_e("SDS011 active reporting failed");
     return false;
   }
-
-  do{
-    last = curr;
-    delay(1000);
-    curr = sds.queryPm();
-    printDebugDisplay({"Initialising SDS011", "Firmware: " + sds.queryFirmwareVersion().toString().substring(35), "Preheating...", "PM2.5:" + String(curr.pm25), 
-                        "PM10:" + String(curr.pm10), "Threshold: " + String(SDS_PREHEAT_THRESHOLD)},  ST7735_WHITE);
-  }while(last.pm10 - curr.pm10 > SDS_PREHEAT_THRESHOLD || last.pm25 - curr.pm25 > SDS_PREHEAT_THRESHOLD);
+#endif
   
   return true;
 }
@@ -279,7 +337,7 @@ bool initSDS()
 /**
  * Initialises the MHZ-19C sensor.
  * 
- * Initialises the MHZ-19C sensor and preheats the sensor .
+ * Initialises the MHZ-19C sensor. The sensor is preheated in the background by the acquisition task (see Warmup).
  * 
  * @return true if initialisation was successfull.
  * @return false if communication with sensor failed at any point during initialisation.
@@ -288,64 +346,509 @@ bool initMHZ()
 {
   mhSerial.begin(9600, SERIAL_8N1, 32, 33);                               
   myMHZ19.begin(mhSerial);                                
+  if(myMHZ19.errorCode != RESULT_OK) return false;
   myMHZ19.autoCalibration(false);
 
-  uint16_t curr = 0;
-  uint16_t last = 0;
-  uint8_t counter = 0;
-  do{
-    last = curr;
-    delay(10000);
-    curr = myMHZ19.getCO2();
-    printDebugDisplay({"Initialising MH-Z19C", "Preheating", "CO2: " + String(curr), "Threshold:" + String(MH_PREHEAT_THRESHOLD)}, ST7735_WHITE);
+#ifdef MH_ONRECEIVE
+  // From here on received bytes are moved into the ring buffer of the event driven reader by the UART-callback
+  mhSerial.onReceive([]() { myMHZ19.onReceive(); });
+#endif
+  
+  return true;
+}
+
+/**
+ * Initialises the BME280 sensor.
+ *
+ * @return false if communication with sensor failed.
+ */
+bool initBME()
+{
+  return bme.begin(0x76);
+}
+
+/**
+ * Stores a sensor reading.
+ * 
+ * Every reading advances the warm-up of the field. Valid readings pass the outlier filter, accepted readings become the latest value and are added to the window statistics.
+ * Failed readings and outliers are only flagged as suspect, the latest accepted value is kept.
+ * @param field The field of the reading.
+ * @param value The fixed point reading.
+ * @param valid false if the reading failed.
+ */
+void storeReading(Field::Id field, int32_t value, bool valid)
+{
+  warmup[field].update(value, valid);
+  if(valid && !outlierFilter[field].isOutlier(value, FIELDS[field].noiseFloor, OUTLIER_THRESHOLD))
+  {
+    current[field] = value;
+    current.suspect &= ~(1 << field);
+    window[field].add(value);
+  }
+  else
+  {
+    current.suspect |= 1 << field;
+  }
+}
+
+/**
+ * Reads the BME280.
+ * 
+ * Temperature, humidity and pressure are read within one I2C-transaction and compensated in fixed point.
+ */
+void sampleBME()
+{
+  if(!bmeRecovery.isUp()) return;
+  bme280_fixed_measurement bme_results = bme.readAllFixed();
+  // A BME280 no longer answering reads as disabled or far outside of its operating range (-40 to 85 C)
+  bool ok = bme_results.temperature != BME280_FIXED_DISABLED && bme_results.temperature >= -4000 && bme_results.temperature <= 8500;
+  if(ok) bmeRecovery.reportOk();
+  else bmeRecovery.reportError(millis());
+  storeReading(Field::TEMPERATURE, bme_results.temperature, ok);                                        // 0.01 C
+  storeReading(Field::HUMIDITY, bme_results.humidity, ok && bme_results.humidity != BME280_FIXED_DISABLED); // 0.01 %
+  storeReading(Field::PRESSURE, bme_results.pressure, ok && bme_results.pressure != BME280_FIXED_DISABLED); // Pa = 0.01 hPa
+}
 
-    if(++counter > 6) // If still not working after 60 seconds, probably faulty connection
+/**
+ * Sends the CO2-request to the MH-Z19C.
+ * 
+ * The response is decoded in the background by the event driven reader of the MH-Z19-library.
+ */
+void requestCO2()
+{
+  if(!mhRecovery.isUp())
+  {
+    co2Requested = false; // a re-initialised sensor has no request outstanding
+    return;
+  }
+  if(co2Requested) mhRecovery.reportError(millis()); // previous request wasn't answered
+  myMHZ19.requestCO2();
+  co2Requested = true;
+}
+
+/**
+ * Sends the PM-query to the SDS011.
+ * 
+ * The response is consumed in the background by sds.poll().
+ */
+void requestPm()
+{
+  if(!sdsRecovery.isUp()) return;
+  sds.queryPmAsync();
+}
+
+/**
+ * Takes over finished sensor responses.
+ * 
+ * Consumes the bytes received from the SDS011 and MH-Z19C, it never blocks. Finished requests and streamed SDS011-frames are stored as reading.
+ * A failed sensor is left to recoveryTask() until it's up again.
+ */
+void readSensors()
+{
+#if SDS_ACTIVE_REPORTING
+  if (sdsRecovery.isUp() && sds.pollStream()){
+    PmResult sds_results = sds.getStreamPm();
+#else
+  if (sdsRecovery.isUp() && sds.poll()){
+    PmResult sds_results = sds.getPendingRequest().toPmResult();
+#endif
+    storeReading(Field::PM25, sds_results.pm25Tenths, sds_results.isOk());
+    storeReading(Field::PM10, sds_results.pm10Tenths, sds_results.isOk());
+#if !SDS_ACTIVE_REPORTING
+    if(sds_results.isOk()) sdsRecovery.reportOk();
+    else sdsRecovery.reportError(millis());
+#endif
+  }
+
+  if(!mhRecovery.isUp()) return;
+#ifndef MH_ONRECEIVE
+  myMHZ19.onReceive(); // no receive callback available, move received bytes into the ring buffer here
+#endif
+  myMHZ19.processFrames(); // only decodes frames already in the ring buffer
+  if (co2Requested && myMHZ19.reading.status != RESULT_NULL){
+    co2Requested = false;
+    bool ok = myMHZ19.reading.status == RESULT_OK;
+    storeReading(Field::CO2, myMHZ19.reading.CO2, ok);
+    if(ok) mhRecovery.reportOk();
+    else mhRecovery.reportError(millis());
+  }
+}
+
+/**
+ * Logs failures, recoveries and downtime of a component, if it ever failed.
+ */
+void logRecovery(const Recovery& recovery)
+{
+  if(recovery.getFailures() == 0) return;
+  log_i("%s: %s, failures %u, recoveries %u, downtime %ums", recovery.getName(), recovery.isUp() ? "up" : "down", recovery.getFailures(), 
+        recovery.getRecoveries(), recovery.getDowntime(millis()));
+}
+
+/**
+ * Publishes the latest sensor values.
+ * 
+ * Pushes a timestamped copy of the latest sensor values and the summaries of the reporting window to the queue of every consumer, then starts a new window.
+ * Fields without a valid reading in the window are summarised by their latest value, fields still warming up are tagged.
+ */
+void publishSample()
+{
+  current.timestamp = millis();
+  current.warming = 0;
+  for(uint8_t i = 0; i < Field::COUNT; i++)
+  {
+    Field::Id field = (Field::Id)i;
+    warmup[field].expire(current.timestamp);
+    if(!warmup[field].isReady()) current.warming |= 1 << field;
+
+    current.summary[field] = window[field].summary();
+    if(window[field].size() == 0)
     {
-      printDebugDisplay({"Initialising MH-Z19C", "Failed to retrieve ", "sensor values!", "Restarting in 10s"}, ST7735_RED);
-      delay(10000);
-      return false;
+      current.summary[field].mean = current.summary[field].min = current.summary[field].max = current[field];
     }
-  }while(last - curr > MH_PREHEAT_THRESHOLD || curr == 0 || last == 0);
-  
-  return true;
+    window[field].reset();
+  }
+  // Fields of failed sensors keep their latest value, but are suspect until the sensor is recovered
+  if(!bmeRecovery.isUp()) current.suspect |= (1 << Field::TEMPERATURE) | (1 << Field::HUMIDITY) | (1 << Field::PRESSURE);
+  if(!sdsRecovery.isUp()) current.suspect |= (1 << Field::PM10) | (1 << Field::PM25);
+  if(!mhRecovery.isUp()) current.suspect |= 1 << Field::CO2;
+  loggerQueue.push(current);
+  displayQueue.push(current);
+
+#if SDS_MEASURE_TRANSPORT
+  printTransportCost();
+#endif
+
+  for(uint8_t i = 0; i < scheduler.jobCount(); i++)
+  {
+    const JobStats& stats = scheduler.getStats(i);
+    log_d("%s: runs %u, overruns %u, lateness mean %lldus, jitter %lldus", scheduler.getName(i), stats.runs, stats.overruns, stats.meanLateness(), stats.jitter());
+  }
+  for(const Recovery* recovery : {&sdsRecovery, &mhRecovery, &bmeRecovery}) logRecovery(*recovery);
 }
 
+/** State of the re-initialisation of a failed sensor, handed between acquisitionTask() and recoveryTask(). */
+enum class Reinit : uint8_t
+{
+  IDLE,
+  REQUESTED, ///< backoff expired, waiting for recoveryTask()
+  SUCCEEDED,
+  FAILED
+};
+
 /**
- * Predefined setup-function.
+ * Failed sensor re-initialised by recoveryTask().
  * 
- * Is called once in the beginning of runtime.
+ * The re-initialisation blocks (sensor commands wait for their responses), therefore it runs in recoveryTask() while acquisitionTask() keeps sampling
+ * the other sensors. The Recovery is only used by acquisitionTask(), the result of the re-initialisation is handed back by state.
  */
-void setup() 
+struct SensorRecovery
+{
+  Recovery& recovery;
+  bool (*init)();
+  uint8_t fields; ///< fields of the sensor, (1 << Field::Id) combined by |
+  std::atomic<uint8_t> state;
+
+  SensorRecovery(Recovery& recovery, bool (*init)(), uint8_t fields) : recovery(recovery), init(init), fields(fields), state((uint8_t)Reinit::IDLE) {}
+};
+
+SensorRecovery sensorRecoveries[] = {
+  SensorRecovery(sdsRecovery, initSDS, (1 << Field::PM10) | (1 << Field::PM25)),
+  SensorRecovery(mhRecovery, initMHZ, 1 << Field::CO2),
+  SensorRecovery(bmeRecovery, initBME, (1 << Field::TEMPERATURE) | (1 << Field::HUMIDITY) | (1 << Field::PRESSURE))
+};
+
+/**
+ * Hands the re-initialisation of every failed sensor whose backoff has expired to recoveryTask() and takes over the results.
+ * 
+ * The warm-up of a recovered sensor starts over.
+ */
+void retrySensors()
+{
+  for(SensorRecovery& sensor : sensorRecoveries)
+  {
+    Reinit state = (Reinit)sensor.state.load(std::memory_order_acquire);
+    if(state == Reinit::IDLE && sensor.recovery.retryDue(millis())) sensor.state.store((uint8_t)Reinit::REQUESTED, std::memory_order_release);
+    if(state != Reinit::SUCCEEDED && state != Reinit::FAILED) continue;
+
+    bool recovered = state == Reinit::SUCCEEDED;
+    sensor.recovery.retried(recovered, millis());
+    if(recovered)
+    {
+      for(uint8_t field = 0; field < Field::COUNT; field++) if(sensor.fields & (1 << field)) warmup[field].restart(millis());
+      log_w("%s recovered", sensor.recovery.getName());
+    }
+    else
+    {
+      log_w("%s still failing, attempt %u", sensor.recovery.getName(), sensor.recovery.getAttempts());
+    }
+    sensor.state.store((uint8_t)Reinit::IDLE, std::memory_order_release);
+  }
+}
+
+/**
+ * Recovery task.
+ * 
+ * Re-initialises the failed sensors requested by retrySensors(), so the blocking sensor commands never delay the acquisition.
+ */
+void recoveryTask(void* arg)
+{
+  for(;;)
+  {
+    for(SensorRecovery& sensor : sensorRecoveries)
+    {
+      if(sensor.state.load(std::memory_order_acquire) != (uint8_t)Reinit::REQUESTED) continue;
+      bool recovered = sensor.init();
+      sensor.state.store((uint8_t)(recovered ? Reinit::SUCCEEDED : Reinit::FAILED), std::memory_order_release);
+    }
+    taskDelay(100); // negligible against the backoff
+  }
+}
+
+/**
+ * Supervises the sensors.
+ * 
+ * Detects a SDS011 no longer streaming and has every failed sensor re-initialised after its backoff, the other sensors keep being sampled.
+ */
+void superviseSensors()
+{
+#if SDS_ACTIVE_REPORTING
+  if(sdsRecovery.isUp())
+  {
+    unsigned long frames = sds.getStreamParser().getFrames();
+    if(frames == sdsFrames) sdsRecovery.reportError(millis()); // a frame is streamed every second
+    else sdsRecovery.reportOk();
+    sdsFrames = frames;
+  }
+#endif
+  retrySensors();
+}
+
+/**
+ * Acquisition task.
+ * 
+ * Runs the sensor jobs of the scheduler and never waits on a consumer. Between the deadlines the responses of the sensors are consumed every SENSOR_POLL_INTERVAL ms.
+ */
+void acquisitionTask(void* arg)
+{
+  scheduler.addJob("bme280", sampleBME, BME_INTERVAL);
+  scheduler.addJob("mhz19", requestCO2, MH_INTERVAL, MH_INTERVAL - MH_QUERY_LEAD);
+#if !SDS_ACTIVE_REPORTING
+  scheduler.addJob("sds011", requestPm, SDS_INTERVAL, LOOPDELAY - SDS_QUERY_LEAD);
+#endif
+  scheduler.addJob("publish", publishSample, LOOPDELAY, LOOPDELAY);
+  scheduler.addJob("recovery", superviseSensors, RECOVERY_INTERVAL, RECOVERY_INTERVAL);
+
+  for(;;)
+  {
+    uint32_t untilNext = scheduler.run();
+    readSensors();
+    taskDelay(untilNext < SENSOR_POLL_INTERVAL ? untilNext : SENSOR_POLL_INTERVAL);
+  }
+}
+
+/**
+ * Records a failed logging attempt.
+ * 
+ * The first failure shows the error, further failed recovery attempts only extend the backoff.
+ */
+void loggerFailed(std::array<String, 8> error)
+{
+  if(loggerRecovery.isUp())
+  {
+    printDebugDisplay(error, ST7735_RED);
+    loggerRecovery.fail(millis());
+  }
+  else
+  {
+    loggerRecovery.retried(false, millis());
+  }
+}
+
+/**
+ * Logger task.
+ * 
+ * Publishes every sample of loggerQueue. A slow or failing logger only delays this task, not the acquisition or the display.
+ * A sample that couldn't be logged (or the batch holding it) is retried with backoff (see Recovery), meanwhile new samples are buffered by loggerQueue.
+ */
+void loggerTask(void* arg)
+{
+  SensorSample sample;
+  bool pending = false; // sample not yet taken over by the logger, retried before any other
+  for(;;)
+  {
+    bool up = loggerRecovery.isUp();
+    if(!up && !loggerRecovery.retryDue(millis()))
+    {
+      taskDelay(10);
+      continue;
+    }
+    if(up && !pending) pending = loggerQueue.pop(sample);
+    bool idle = up && !pending;
+
+    uint16_t buffered = logger->buffered();
+    try
+    {
+      if(pending) logger->log(sample);
+      else logger->flush(); // posts a batch that's due by its age, or retries a failed batch
+      pending = false;
+      if(!up)
+      {
+        loggerRecovery.retried(true, millis());
+        logRecovery(loggerRecovery);
+      }
+    }catch(LoggerException& e)
+    {
+      pending = pending && logger->buffered() <= buffered; // a batching logger keeps the sample even if posting the batch failed
+      loggerFailed({"A Logger Exception", "occured!" ,"IP: " + WiFi.localIP().toString(), "Host: " + String(WiFi.getHostname()), 
+                    "WiFi connected: " + String(WiFi.isConnected()), "Retrying in background", String(e.error), e.what()});
+    }catch(WifiNotConnectedException& e) 
+    {
+      pending = pending && logger->buffered() <= buffered;
+      WiFi.reconnect(); // doesn't block, the sample is retried once the backoff expired
+      loggerFailed({"WiFi connection lost!", "Reconnecting..."});
+    }
+
+    if(idle) taskDelay(10);
+  }
+}
+
+/**
+ * Initialises the TFT.
+ *
+ * Boot stage, every other stage depends on it since they report their progress on the display.
+ */
+bool initTFT()
 {
-  Serial.begin(9600);
-  // Init TFT
   tft.initR(INITR_BLACKTAB); 
   tft.fillScreen(ST7735_BLACK);
   tft.setTextSize(1);
+  return true;
+}
 
-  if(!initSDS()) ESP.restart();
-  if(!initMHZ()) ESP.restart();
-
-  // Init BME280
-  if(!bme.begin(0x76))
+/**
+ * Boot stage initialising a sensor.
+ * 
+ * A failing sensor doesn't stop the boot, it's marked as failed and recovered by the acquisition task while the other sensors are sampled.
+ * @param name Name of the sensor on the display.
+ * @param init Initialises the sensor.
+ * @param recovery Recovery of the sensor.
+ */
+bool bootSensor(const char* name, bool (*init)(), Recovery& recovery)
+{
+  printDebugDisplay({"Initialising " + String(name)}, ST7735_WHITE);
+  if(!init())
   {
-    printDebugDisplay({"Initialising BME280", "Failed to communicate with BME280", "Restarting in 10s"}, ST7735_RED);
-    delay(10000);
-    ESP.restart();
+    printDebugDisplay({"Initialising " + String(name), "Initialisation failed", "Retrying in background"}, ST7735_RED);
+    recovery.fail(millis());
   }
-  // Setup WiFi-connection
+  return true;
+}
+
+/**
+ * Boot stage connecting to WiFi, restarts the ESP32 itself if the connection fails (see connectWifi()).
+ */
+bool initWifi()
+{
   printDebugDisplay({"Connecting to WiFi", "SSID: " + String(SSID)}, ST7735_WHITE);
   connectWifi();
+  return true;
+}
 
-  // Setup Server
+/**
+ * Boot stage starting the OTA-server.
+ */
+bool initOTA()
+{
   printDebugDisplay({"Initialising OTA-Server", "SSID: " + String(SSID), "IP: " + WiFi.localIP().toString(), "Host: " + String(WiFi.getHostname()), 
                      "WiFi connected: " + String(WiFi.isConnected())}, ST7735_WHITE);
   initElegentOTA();
-  
-  // Init logger
+  return true;
+}
+
+/**
+ * Boot stage starting the acquisition task and the recovery task, from here on samples are taken.
+ */
+bool startAcquisition()
+{
+  if(!startTask(acquisitionTask, "acquisition", ACQUISITION_STACK_SIZE, NULL, 2, 1) || !startTask(recoveryTask, "recovery", RECOVERY_STACK_SIZE, NULL, 1, 1))
+  {
+    printDebugDisplay({"Starting acquisition failed", "Restarting in 10s"}, ST7735_RED);
+    delay(10000);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Boot stage creating the logger and starting the logger task.
+ * 
+ * Samples taken before are kept in the loggerQueue until it's full.
+ */
+bool startLogging()
+{
   printDebugDisplay({"Initialising logger!"}, ST7735_WHITE);
-  logger = new HTTPLogger();
-  timer = 0;
+  logger = new LOGGER();
+  if(!startTask(loggerTask, "logger", LOGGER_STACK_SIZE, NULL, 1, 0))
+  {
+    printDebugDisplay({"Starting logger failed", "Restarting in 10s"}, ST7735_RED);
+    delay(10000);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Prints the boot timeline to Serial.
+ */
+void printBootTimeline(const BootOrchestrator& boot)
+{
+  static const char* states[] = {"waiting", "running", "done", "failed", "skipped"};
+  Serial.println("Boot timeline:");
+  for(uint8_t i = 0; i < boot.stageCount(); i++)
+  {
+    BootOrchestrator::StageTiming timing = boot.getTiming(i);
+    Serial.printf("  %-12s %6lu - %6lu ms  %s\n", timing.name, (unsigned long)(timing.start / 1000), (unsigned long)(timing.end / 1000), 
+                  states[(uint8_t)timing.state]);
+  }
+}
+
+/**
+ * Predefined setup-function.
+ * 
+ * Is called once in the beginning of runtime.
+ * The initialisation runs as boot stages, each stage starts as soon as the stages it depends on are done. Sensors on different buses
+ * and the WiFi-connection are initialised concurrently, so the first sample is taken once the slowest sensor is ready instead of after all of them
+ * and the network isn't delayed by the sensors.
+ */
+void setup() 
+{
+  Serial.begin(9600);
+
+#if SDS_MEASURE_TRANSPORT
+  // Calibrate while core 1 is still idle, before any serial ISR is attached and before the boot stages run
+  initTFT();
+  printDebugDisplay({"Calibrating load meter"}, ST7735_WHITE);
+  loadMeter.begin(1);
+#endif
+
+  BootOrchestrator boot;
+#if SDS_MEASURE_TRANSPORT
+  uint16_t display = boot.addStage("display", []() { return true; }); // already initialised for the calibration
+#else
+  uint16_t display = boot.addStage("display", initTFT);
+#endif
+  uint16_t sds011 = boot.addStage("sds011", []() { return bootSensor("SDS011", initSDS, sdsRecovery); }, display);
+  uint16_t mhz19 = boot.addStage("mhz19", []() { return bootSensor("MH-Z19C", initMHZ, mhRecovery); }, display);
+  uint16_t bme280 = boot.addStage("bme280", []() { return bootSensor("BME280", initBME, bmeRecovery); }, display);
+  uint16_t wifi = boot.addStage("wifi", initWifi, display, 0);
+  boot.addStage("ota", initOTA, wifi, 0);
+  boot.addStage("acquisition", startAcquisition, sds011 | mhz19 | bme280);
+  boot.addStage("logging", startLogging, wifi, 0);
+
+  bool booted = boot.run(BOOT_STAGE_STACK_SIZE);
+  printBootTimeline(boot);
+  // The failed stage has already shown its error
+  if(!booted) ESP.restart();
 }
 
 /**
@@ -355,33 +858,15 @@ void setup()
  */
 void loop()
 {
-  if(timer == LOOPDELAY)
-  {
-    timer = 0;
-    try
-    {
-      readSensors();
-      logger->log(sensorData);
-      printRegularDisplay();
-    }catch(LoggerException& e)
-    {
-      printDebugDisplay({"A Logger Exception", "occured!" ,"IP: " + WiFi.localIP().toString(), "Host: " + String(WiFi.getHostname()), 
-                          "WiFi connected: " + String(WiFi.isConnected()), "Reset in " + String(LOOPDELAY/1000) + "s", String(e.error), e.what()}, ST7735_RED);
-      delay(LOOPDELAY);
-      ESP.restart();
-    }catch(WifiNotConnectedException& e) 
-    {
-      printDebugDisplay({"WiFi connection lost!", "Reconnecting..."}, ST7735_RED);
-      connectWifi();
-    }
-  }
+  SensorSample sample;
+  if(displayQueue.popLatest(sample)) printRegularDisplay(sample);
 
   /**
    * The AsyncElegantOTA.loop() statement must be called repeatedly throughout the loop function. Pausing the loop function directly by delay(LOOPDELAY)
    * would cause unpredictable errors from the OTA-service, since the AsyncElegantOTA.loop() statement wouldn't be called for extended periods of time.
-   * Therefore, the loop is only paused for 1ms, and instead the counter-var 'timer' is introduced.
+   * Sensors and logger run in their own tasks, therefore the loop is only paused for 1ms.
    */
 
   AsyncElegantOTA.loop();
-  delay(1); timer++;
+  delay(1);
 }
@@ -7,46 +7,132 @@
 #include "Arduino.h"
 #include "config.h"
 #include "Logger.h"
-
-#include <HTTPClient.h>
+#include "JsonWriter.h"
+#include "AsyncHTTPClient.h"
 
 
+/**
+ * HTTPLogger class implementing Logger interface
+ * 
+ * Posts the samples as JSON to HTTPSERVER, one sample per request or batches of up to HTTP_BATCH_SIZE samples.
+ * The requests are sent by the non-blocking AsyncHTTPClient, logging doesn't wait for the connection or the server.
+ */
 class HTTPLogger : public Logger
 {
     private:
-        WiFiClient wifiClient;
-        HTTPClient httpClient;
+        /** Largest size of the object of one sample, computed from FIELDS at compile time. */
+        static const size_t OBJECT_SIZE = jsonObjectSize(jsonFieldsLength(LOG_SUMMARY) + jsonMemberLength(constLength("mac"), 0, 17)
+                                                         + (HTTP_BATCH_SIZE > 1 ? jsonMemberLength(constLength("seq"), 0, 10) : 0));
 
-    public:
-        HTTPLogger(){};
+        /** Size of the payload buffer, every object is followed by its separator, plus the brackets of the array. */
+        static const size_t PAYLOAD_SIZE = HTTP_BATCH_SIZE * OBJECT_SIZE + 2;
 
+        AsyncHTTPClient<PAYLOAD_SIZE, HTTP_QUEUE_SIZE> httpClient;
+        char payload[PAYLOAD_SIZE];
+        size_t length = 0;        ///< length of the batch in payload
+        uint16_t count = 0;       ///< samples in the batch
+        uint32_t batchStart = 0;  ///< millis() when the first sample of the batch was added
+        uint32_t sequence = 0;    ///< sequence number of the next sample
+        char mac[18];             ///< formatted once like WiFi.macAddress()
 
         /**
-         * Publishes the current sensor values 
-         * 
-         * @exception WiFiNotConnectedException Thrown if no WiFi connection available
-         * @exception LoggerException Thrown if HTTP-POST returned an invalid response code
-         * @param sensorData the sensor values to be published
+         * Adds a sample to the batch.
          */
-    void log(const std::map<const char*, double>* sensorData)
-    {
-        String payload = "{";   
-        for(auto const& iter : *sensorData)
+        void append(const SensorSample& sample)
         {
-            payload += "\"" + String(iter.first) + "\"" + ":\"" + String(iter.second) + "\",";
+            if(count == 0)
+            {
+                batchStart = millis();
+                length = 0;
+                if(HTTP_BATCH_SIZE > 1 && !HTTP_BATCH_NDJSON) payload[length++] = '[';
+            }
+            else if(!HTTP_BATCH_NDJSON)
+            {
+                payload[length++] = ',';
+            }
+
+            JsonWriter json(payload + length, sizeof(payload) - length);
+            forEachPublishedValue(sample, LOG_SUMMARY, [&](const FieldDescriptor& field, Suffix::Id suffix, const char* value)
+            {
+                json.member(field.jsonKey, SUFFIXES[suffix], value);
+            });
+            json.member("mac", "", mac);
+            if(HTTP_BATCH_SIZE > 1)
+            {
+                char seq[11];
+                formatUnsigned(seq, sizeof(seq), sequence);
+                json.member("seq", "", seq);
+            }
+            json.end();
+            length += json.getLength();
+            if(HTTP_BATCH_NDJSON) payload[length++] = '\n';
+
+            sequence++;
+            count++;
         }
-        payload += "\"mac\":\"" + String(WiFi.macAddress()) + "\"}";
-        payload = payload.substring(0, payload.length()-1);
-        payload += "}";
 
-        httpClient.begin(HTTPSERVER);
-        httpClient.addHeader("Content-Type", "application/json");
-        int httpResponseCode = httpClient.POST(payload);
+        /**
+         * Hands the batch to the request queue, the request is sent in the background.
+         * 
+         * @exception LoggerException Thrown if the request queue is full, the batch is kept
+         */
+        void post()
+        {
+            size_t size = length;
+            if(HTTP_BATCH_SIZE > 1 && !HTTP_BATCH_NDJSON) payload[size++] = ']'; // overwritten by the separator if the batch is extended
 
-        if(httpResponseCode != 200){
-            throw LoggerException(httpClient.errorToString(httpResponseCode).c_str(), httpResponseCode);
+            if(!httpClient.post((uint8_t*)payload, size, count)) throw LoggerException("Request queue full!", -1);
+            log_d("HTTPLogger: samples %u to %u queued", sequence - count, sequence - 1);
+            count = 0;
+            length = 0;
         }
 
-        httpClient.end();
+    public:
+        HTTPLogger() : httpClient(HTTPSERVER, HTTP_BATCH_NDJSON ? "application/x-ndjson" : "application/json")
+        {
+            uint8_t address[6];
+            WiFi.macAddress(address);
+            snprintf(mac, sizeof(mac), "%02X:%02X:%02X:%02X:%02X:%02X", address[0], address[1], address[2], address[3], address[4], address[5]);
+        };
+
+
+        /**
+         * Publishes the current sensor values 
+         * 
+         * The sample is added to the batch, the batch is queued once it's due. The JSON-payload is written into a fixed buffer, no heap memory is allocated for it.
+         * Returns at once, the outcome of the request is reported by a later flush().
+         * @exception LoggerException Thrown if the request queue is full (the sample is kept in the batch) or a previous request failed
+         * @param sample the sensor values to be published
+         */
+    void log(const SensorSample& sample)
+    {
+        if(count == HTTP_BATCH_SIZE) post(); // a failed batch is still full
+        append(sample);
+        flush();
     }
+
+    /**
+     * Reports a failed request and queues the batch once it holds HTTP_BATCH_SIZE samples or its oldest sample is HTTP_BATCH_AGE ms old.
+     * 
+     * A failed request stays at the head of the queue, it's started again when reported (so the retries follow the backoff of the logger task).
+     * @exception LoggerException Thrown if a request failed (HTTP-response code or HTTPClient-error) or the request queue is full
+     */
+    void flush()
+    {
+        int httpResponseCode = httpClient.retryFailed();
+        if(httpResponseCode != 0) throw LoggerException(HTTPClient::errorToString(httpResponseCode).c_str(), httpResponseCode);
+        if(count >= HTTP_BATCH_SIZE || (count > 0 && millis() - batchStart >= HTTP_BATCH_AGE)) post();
+    }
+
+    /** @return samples in the batch and in the queued requests, until the server acknowledged them. */
+    uint16_t buffered() const { return count + httpClient.queued(); }
+
+    /** @return share of the requests sent over a kept alive connection in 0.1 %. */
+    uint16_t getReuseRatio() const { return httpClient.getReuseRatio(); }
+
+    /** @return mean latency of the requests in us (from starting the request until the response is complete). */
+    int64_t getMeanLatency() const { return httpClient.getMeanLatency(); }
+
+    /** @return largest latency of the requests in us. */
+    int64_t getMaxLatency() const { return httpClient.getMaxLatency(); }
 };
@@ -7,6 +7,7 @@
 #include "Arduino.h"
 #include "config.h"
 #include "Logger.h"
+#include "MQTTPublisher.h"
 
 #include "Adafruit_MQTT.h"
 #include "Adafruit_MQTT_Client.h"
@@ -15,7 +16,7 @@
 /**
  *  MQTTLogger class implementing Logger interface
  */
-class MQTTLogger : public Logger
+class MQTTLogger : public MQTTPublisher
 {
   private:
     WiFiClient wifiClient;
@@ -42,6 +43,42 @@ class MQTTLogger : public Logger
 
     }
     
+    /**
+     * Publishes a payload.
+     * 
+     * With QoS 1 the PUBACK isn't awaited here, but by acknowledge() once all packets of the sample are sent.
+     * A packet that doesn't fit into the packet buffer is sent straight from the payload and its PUBACK awaited right away, see Adafruit_MQTT::publishDirect().
+     * @exception LoggerException Thrown if the packet couldn't be sent
+     */
+    void publish(const char* topic, uint8_t* payload, uint16_t length)
+    {
+      // fixed header (up to 3 bytes), topic length and packet id (2 bytes each) precede topic and payload
+      if(7 + strlen(topic) + length > MAXBUFFERSIZE)
+      {
+        if(!mqttClient->publishDirect(topic, payload, length, MQTT_QOS)) throw LoggerException("Publish failed!", -1);
+        return;
+      }
+#if MQTT_QOS
+      if(!mqttClient->publishPipelined(topic, payload, length))
+      {
+        mqttClient->discardInflight(); // the whole sample is retried
+        throw LoggerException("Publish failed!", -1);
+      }
+#else
+      if(!mqttClient->publish(topic, payload, length, 0)) throw LoggerException("Publish failed!", -1);
+#endif
+    }
+
+    /**
+     * Waits for the PUBACKs of all packets in flight, overdue packets are retransmitted.
+     * 
+     * @exception LoggerException Thrown if not all packets were acknowledged within MQTT_ACK_TIMEOUT, they stay in flight (see flush())
+     */
+    void acknowledge()
+    {
+      if(!mqttClient->flushPipelined(MQTT_ACK_TIMEOUT)) throw LoggerException("Publish not acknowledged!", -1);
+    }
+
   public:
     /**
      * Initialises MQTTLogger
@@ -53,28 +90,36 @@ class MQTTLogger : public Logger
     /**
      * Publishes the current sensor values 
      * 
+     * Depending on MQTT_PUBLISH_MODE all values are published within a single packet or fanned out to one feed per value.
      * @exception WiFiNotConnectedException Thrown if no WiFi connection available
-     * @exception LoggerException TThrown if connecting to broker failed
-     * @param sensorData the sensor values to be published
+     * @exception LoggerException Thrown if connecting to broker or publishing failed
+     * @param sample the sensor values to be published
      */
-    void log(const std::map<const char*, double>* sensorData)
+    void log(const SensorSample& sample)
     {
-      for(auto const& iter : *sensorData)
-      {
-        
-        char* feed = (char*) malloc(strlen(AIOUSERNAME) + strlen("/feeds/") + strlen(iter.first) + 1);
-        strcpy(feed, AIOUSERNAME);
-        strcat(feed, "/feeds/");
-        strcat(feed, iter.first);
-
-        char* payload = (char*) malloc(41); // TODO
-        dtostrf(iter.second, 0, 2, payload);
-
-        connectMQTT();
-        mqttClient->publish(feed, payload, 0);
+      connectMQTT();
+      publishSample(sample);
+#if MQTT_QOS
+      acknowledge();
+#endif
+    }
 
-        free(feed);
-        free(payload);
-      }
+    /**
+     * Waits again for the PUBACKs of a sample that wasn't acknowledged, the connection is restored and the packets retransmitted if necessary.
+     * 
+     * PUBACKs that arrived late are taken without blocking first, see Adafruit_MQTT::poll().
+     * @exception WiFiNotConnectedException Thrown if no WiFi connection available
+     * @exception LoggerException Thrown if connecting to broker failed or the packets still weren't acknowledged
+     */
+    void flush()
+    {
+      if(mqttClient->inflight() == 0) return;
+      mqttClient->poll();
+      if(mqttClient->inflight() == 0) return;
+      connectMQTT();
+      acknowledge();
     }
+
+    /** @return number of packets awaiting their PUBACK. */
+    uint16_t buffered() const { return mqttClient->inflight(); }
 };
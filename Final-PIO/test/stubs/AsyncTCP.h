@@ -0,0 +1,134 @@
+/**
+ * @file AsyncTCP.h
+ * @author Simon Schimik
+ * @version 3.0
+ *
+ * Host stand-in for the AsyncClient of AsyncTCP, shared by the tests of the async clients.
+ *
+ * The test plays the server and the TCP stack: it accepts or refuses the connection attempt, delivers data, ACKs what the client sent and
+ * closes the connection. Like AsyncTCP, close() only closes an established connection and then calls onDisconnect right away, before the
+ * connection is established there is nothing to close. A refused attempt calls onDisconnect as well.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <string>
+
+class AsyncClient;
+
+typedef std::function<void(void*, AsyncClient*)> AcConnectHandler;
+typedef std::function<void(void*, AsyncClient*, size_t len, uint32_t time)> AcAckHandler;
+typedef std::function<void(void*, AsyncClient*, void *data, size_t len)> AcDataHandler;
+typedef std::function<void(void*, AsyncClient*, uint32_t time)> AcTimeoutHandler;
+
+class AsyncClient
+{
+  private:
+    AcConnectHandler connectHandler;
+    AcConnectHandler disconnectHandler;
+    AcAckHandler ackHandler;
+    AcDataHandler dataHandler;
+    AcTimeoutHandler timeoutHandler;
+
+    std::string added; ///< added, not yet sent
+
+    void disconnect()
+    {
+      established = false;
+      added.clear();
+      unacked = 0;
+      if(disconnectHandler) disconnectHandler(NULL, this);
+    }
+
+  public:
+    static inline AsyncClient* created = NULL; ///< AsyncClient constructed last, the test plays its server
+
+    size_t window = 5744;     ///< size of the TCP window
+    size_t unacked = 0;       ///< bytes sent and not yet ACKed by the server
+    std::string sent;         ///< bytes sent by the client over the current connection
+    bool failConnect = false; ///< connect() fails right away
+    bool connecting = false;  ///< an attempt is neither accepted nor refused yet
+    bool established = false;
+    uint16_t connects = 0;    ///< connection attempts started
+    uint16_t closes = 0;      ///< established connections closed by the client
+
+    AsyncClient() { created = this; }
+
+    void onConnect(AcConnectHandler cb, void* = 0) { connectHandler = cb; }
+    void onDisconnect(AcConnectHandler cb, void* = 0) { disconnectHandler = cb; }
+    void onAck(AcAckHandler cb, void* = 0) { ackHandler = cb; }
+    void onData(AcDataHandler cb, void* = 0) { dataHandler = cb; }
+    void onTimeout(AcTimeoutHandler cb, void* = 0) { timeoutHandler = cb; }
+
+    bool connect(const char*, uint16_t)
+    {
+      if(established || failConnect) return false;
+      connecting = true;
+      connects++;
+      return true;
+    }
+
+    void close(bool = false)
+    {
+      if(!established) return;
+      closes++;
+      disconnect();
+    }
+
+    size_t space() { return established ? window - unacked - added.size() : 0; }
+
+    size_t add(const char* data, size_t size, uint8_t = 0)
+    {
+      if(size > space()) size = space();
+      added.append(data, size);
+      return size;
+    }
+
+    bool send()
+    {
+      if(!established) return false;
+      sent += added;
+      unacked += added.size();
+      added.clear();
+      return true;
+    }
+
+    /** The server accepts the connection attempt. */
+    void accept()
+    {
+      connecting = false;
+      established = true;
+      sent.clear();
+      if(connectHandler) connectHandler(NULL, this);
+    }
+
+    /** The server refuses the connection attempt. */
+    void refuse()
+    {
+      connecting = false;
+      disconnect();
+    }
+
+    /** The server sends data. */
+    void receive(const std::string& data)
+    {
+      if(dataHandler) dataHandler(NULL, this, (void*)data.data(), data.size());
+    }
+
+    /** The server ACKs all bytes sent. */
+    void ack()
+    {
+      size_t length = unacked;
+      unacked = 0;
+      if(ackHandler) ackHandler(NULL, this, length, 10);
+    }
+
+    /** The server closes the connection or it breaks. */
+    void drop()
+    {
+      if(established) disconnect();
+    }
+};
@@ -0,0 +1,72 @@
+/**
+ * @file esp_timer.h
+ * @author Simon Schimik
+ * @version 3.0
+ *
+ * Host stand-in for the esp_timer API of ESP-IDF, shared by the tests of the async clients. The timers never fire on their own,
+ * the test calls runTimers() after advancing the simulated clock.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+
+typedef void (*esp_timer_cb_t)(void* arg);
+
+struct esp_timer_create_args_t
+{
+  esp_timer_cb_t callback;
+  void* arg;
+  int dispatch_method;
+  const char* name;
+  bool skip_unhandled_events;
+};
+
+struct esp_timer
+{
+  esp_timer_cb_t callback;
+  void* arg;
+  uint64_t period; ///< us, 0 if stopped
+};
+
+typedef esp_timer* esp_timer_handle_t;
+
+inline std::vector<esp_timer_handle_t> timers;
+
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* handle)
+{
+  *handle = new esp_timer{args->callback, args->arg, 0};
+  timers.push_back(*handle);
+  return ESP_OK;
+}
+
+inline esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+  timer->period = period;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+  timer->period = 0;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+  timers.erase(std::remove(timers.begin(), timers.end(), timer), timers.end());
+  delete timer;
+  return ESP_OK;
+}
+
+/** Calls every started timer once. */
+inline void runTimers()
+{
+  std::vector<esp_timer_handle_t> started = timers;
+  for(esp_timer_handle_t timer : started) if(timer->period) timer->callback(timer->arg);
+}
@@ -0,0 +1,24 @@
+/**
+ * @file Arduino.h
+ * @author Simon Schimik
+ * @version 3.0
+ *
+ * Host stand-in for the parts of the Arduino core AsyncHTTPClient uses, millis() is the simulated clock of the test.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/** Simulated time in ms, advanced by the test. */
+inline uint32_t simulatedMillis = 0;
+
+inline unsigned long millis() { return simulatedMillis; }
+
+/** Discards the log output of the ESP32 core. */
+template<typename... Args> inline void log_e(const char*, Args...) {}
+template<typename... Args> inline void log_d(const char*, Args...) {}
@@ -0,0 +1,14 @@
+/**
+ * @file HTTPClient.h
+ * @author Simon Schimik
+ * @version 3.0
+ *
+ * Host stand-in for the error codes of the HTTPClient of the ESP32 core, AsyncHTTPClient reports its errors with them.
+ */
+
+#pragma once
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_NO_HTTP_SERVER (-7)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
@@ -0,0 +1,222 @@
+/**
+ * @file test_main.cpp
+ * @author Simon Schimik
+ * @version 3.0
+ *
+ * Host test of the AsyncHTTPClient against a stand-in of the AsyncClient of AsyncTCP.
+ *
+ * The test plays the server on the AsyncClient stand-in: it accepts or refuses the connection, checks the requests sent, answers them and
+ * closes the connection. The clock (millis()) is simulated, the timeout timer is run by the test after advancing it.
+ */
+
+#include <unity.h>
+#include <string>
+#include "AsyncHTTPClient.h"
+
+typedef AsyncHTTPClient<256, 4> Client;
+
+static const char BODY[] = "{\"temperature\":\"21.50\"}";
+static const std::string OK("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+
+static Client* client;
+static AsyncClient* server;
+
+/** @return request with BODY as the client sends it. */
+static std::string request()
+{
+  return std::string("POST /api/log HTTP/1.1\r\nHost: example.com\r\nContent-Type: application/json\r\nConnection: keep-alive\r\n"
+                     "Content-Length: ") + std::to_string(strlen(BODY)) + "\r\n\r\n" + BODY;
+}
+
+static bool post()
+{
+  return client->post((const uint8_t*)BODY, strlen(BODY), 1);
+}
+
+/** Asserts that the client sent exactly the expected bytes since the last call. */
+static void assertSent(const std::string& expected)
+{
+  TEST_ASSERT_EQUAL_STRING(expected.c_str(), server->sent.c_str());
+  server->sent.clear();
+}
+
+/** Delivers the data to the client one byte at a time. */
+static void receiveBytewise(const std::string& data)
+{
+  for(char c : data) server->receive(std::string(1, c));
+}
+
+void setUp()
+{
+  simulatedMillis = 1000;
+  client = new Client("http://example.com:8080/api/log", "application/json");
+  server = AsyncClient::created;
+}
+
+void tearDown()
+{
+  delete client;
+}
+
+void test_post_is_sent_once_connected()
+{
+  TEST_ASSERT_TRUE(post());
+  TEST_ASSERT_EQUAL_UINT16(1, server->connects);
+  TEST_ASSERT_EQUAL_UINT16(1, client->queued());
+
+  server->accept();
+  assertSent(request());
+  server->receive(OK);
+  TEST_ASSERT_EQUAL_UINT16(0, client->queued());
+  TEST_ASSERT_EQUAL_INT(0, client->retryFailed());
+  TEST_ASSERT_EQUAL_UINT16(0, server->closes);
+}
+
+void test_requests_reuse_the_kept_alive_connection()
+{
+  TEST_ASSERT_TRUE(post());
+  TEST_ASSERT_TRUE(post());
+  server->accept();
+  assertSent(request()); // one request at a time
+
+  server->receive(OK);
+  assertSent(request());
+  server->receive(OK);
+  TEST_ASSERT_EQUAL_UINT16(0, client->queued());
+  TEST_ASSERT_EQUAL_UINT16(1, server->connects);
+  TEST_ASSERT_EQUAL_UINT16(500, client->getReuseRatio());
+}
+
+void test_body_waits_for_the_tcp_window()
+{
+  server->window = 32;
+  TEST_ASSERT_TRUE(post());
+  server->accept();
+  TEST_ASSERT_EQUAL_size_t(32, server->sent.size());
+
+  while(server->unacked) server->ack();
+  assertSent(request());
+}
+
+void test_continue_and_chunked_response()
+{
+  TEST_ASSERT_TRUE(post());
+  server->accept();
+  receiveBytewise("HTTP/1.1 100 Continue\r\n\r\n"
+                  "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n4\r\nabcd\r\n0\r\nX-Trailer: 1\r\n\r\n");
+  TEST_ASSERT_EQUAL_UINT16(0, client->queued());
+  TEST_ASSERT_EQUAL_INT(0, client->retryFailed());
+  TEST_ASSERT_EQUAL_UINT16(0, server->closes);
+}
+
+void test_response_ending_with_the_connection()
+{
+  TEST_ASSERT_TRUE(post());
+  server->accept();
+  server->receive("HTTP/1.0 200 OK\r\n\r\nok");
+  TEST_ASSERT_EQUAL_UINT16(1, client->queued()); // the body may go on
+  server->drop();
+  TEST_ASSERT_EQUAL_UINT16(0, client->queued());
+
+  TEST_ASSERT_TRUE(post());
+  TEST_ASSERT_EQUAL_UINT16(2, server->connects);
+  server->accept();
+  server->receive("HTTP/1.1 204 No Content\r\nConnection: close\r\n\r\n");
+  TEST_ASSERT_EQUAL_UINT16(0, client->queued());
+  TEST_ASSERT_EQUAL_UINT16(1, server->closes);
+  TEST_ASSERT_EQUAL_INT(0, client->retryFailed());
+}
+
+void test_failed_request_waits_for_retry()
+{
+  TEST_ASSERT_TRUE(post());
+  server->accept();
+  server->receive("HTTP/1.1 500 Internal Server Error\r\nContent-Length: 0\r\n\r\n");
+  TEST_ASSERT_EQUAL_UINT16(1, server->closes);
+  TEST_ASSERT_EQUAL_UINT16(1, client->queued());
+
+  simulatedMillis += 1000;
+  runTimers();
+  TEST_ASSERT_EQUAL_UINT16(1, server->connects); // paused
+
+  TEST_ASSERT_EQUAL_INT(500, client->retryFailed());
+  TEST_ASSERT_EQUAL_UINT16(2, server->connects);
+  server->accept();
+  assertSent(request());
+  server->receive(OK);
+  TEST_ASSERT_EQUAL_UINT16(0, client->queued());
+}
+
+void test_refused_connection_fails_the_request()
+{
+  TEST_ASSERT_TRUE(post());
+  server->refuse();
+  TEST_ASSERT_EQUAL_INT(HTTPC_ERROR_CONNECTION_REFUSED, client->retryFailed());
+  TEST_ASSERT_EQUAL_UINT16(2, server->connects);
+}
+
+/** The server closes the kept alive connection before it answered the next request, which is sent again on a new one without failing. */
+void test_closed_kept_alive_connection_is_reconnected()
+{
+  TEST_ASSERT_TRUE(post());
+  server->accept();
+  server->sent.clear();
+  server->receive(OK);
+
+  TEST_ASSERT_TRUE(post());
+  assertSent(request());
+  server->drop();
+  runTimers();
+  TEST_ASSERT_EQUAL_UINT16(2, server->connects);
+  server->accept();
+  assertSent(request());
+  server->receive(OK);
+  TEST_ASSERT_EQUAL_UINT16(0, client->queued());
+  TEST_ASSERT_EQUAL_INT(0, client->retryFailed());
+}
+
+/** Regression: a timed out connection attempt left the connection CONNECTING, so the retry never connected again. */
+void test_connect_timeout_fails_the_request()
+{
+  TEST_ASSERT_TRUE(post());
+  simulatedMillis += HTTP_TIMEOUT + 1;
+  runTimers();
+
+  // the abandoned attempt succeeds late, the connection is closed again without a request
+  server->accept();
+  TEST_ASSERT_EQUAL_UINT16(1, server->closes);
+  TEST_ASSERT_TRUE(server->sent.empty());
+
+  TEST_ASSERT_EQUAL_INT(HTTPC_ERROR_READ_TIMEOUT, client->retryFailed());
+  TEST_ASSERT_EQUAL_UINT16(2, server->connects);
+  server->accept();
+  assertSent(request());
+  server->receive(OK);
+  TEST_ASSERT_EQUAL_UINT16(0, client->queued());
+}
+
+void test_response_timeout_fails_the_request()
+{
+  TEST_ASSERT_TRUE(post());
+  server->accept();
+  simulatedMillis += HTTP_TIMEOUT + 1;
+  runTimers();
+  TEST_ASSERT_EQUAL_UINT16(1, server->closes);
+  TEST_ASSERT_EQUAL_INT(HTTPC_ERROR_READ_TIMEOUT, client->retryFailed());
+}
+
+int main(int, char**)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_post_is_sent_once_connected);
+  RUN_TEST(test_requests_reuse_the_kept_alive_connection);
+  RUN_TEST(test_body_waits_for_the_tcp_window);
+  RUN_TEST(test_continue_and_chunked_response);
+  RUN_TEST(test_response_ending_with_the_connection);
+  RUN_TEST(test_failed_request_waits_for_retry);
+  RUN_TEST(test_refused_connection_fails_the_request);
+  RUN_TEST(test_closed_kept_alive_connection_is_reconnected);
+  RUN_TEST(test_connect_timeout_fails_the_request);
+  RUN_TEST(test_response_timeout_fails_the_request);
+  return UNITY_END();
+}
@@ -0,0 +1,11 @@
+/**
+ * @file Adafruit_MQTT.h
+ * @author Simon Schimik
+ * @version 3.0
+ *
+ * Forwards to the header of the Adafruit MQTT Library, which isn't on the include path of the native environment.
+ */
+
+#pragma once
+
+#include "../../.pio/libdeps/esp32dev/Adafruit MQTT Library/Adafruit_MQTT.h"
@@ -0,0 +1,220 @@
+/**
+ * @file test_main.cpp
+ * @author Simon Schimik
+ * @version 3.0
+ *
+ * Host test of the AsyncMQTTClient against a stand-in of the AsyncClient of AsyncTCP.
+ *
+ * The test plays the broker on the AsyncClient stand-in: it accepts the connection, answers with CONNACK, PUBACK and PINGRESP and ACKs
+ * the bytes sent. The clock (millis()) is simulated, the keep-alive timer is run by the test after advancing it.
+ */
+
+#include <unity.h>
+#include <string>
+#include "../../.pio/libdeps/esp32dev/Adafruit MQTT Library/Adafruit_MQTT.cpp"
+#include "AsyncMQTTClient.h"
+
+typedef AsyncMQTTClient<128, 4> Client;
+
+static const uint16_t KEEP_ALIVE = 60; // s
+static const char TOPIC[] = "user/feeds/temperature";
+static const uint8_t PAYLOAD[] = "21.50";
+
+static const std::string CONNACK("\x20\x02\x00\x00", 4);
+static const std::string PINGREQ("\xC0\x00", 2);
+static const std::string PINGRESP("\xD0\x00", 2);
+
+static Client* client;
+static AsyncClient* server;
+
+/** @return PUBLISH-packet of PAYLOAD to TOPIC as the client encodes it, QoS 1 if packetId isn't 0. */
+static std::string publishPacket(uint16_t packetId, bool duplicate = false)
+{
+  std::string packet(1, (char)(MQTT_CTRL_PUBLISH << 4 | (packetId ? MQTT_QOS_1 << 1 : 0) | (duplicate ? 0x08 : 0)));
+  packet += (char)(2 + strlen(TOPIC) + (packetId ? 2 : 0) + 5);
+  packet += (char)0;
+  packet += (char)strlen(TOPIC);
+  packet += TOPIC;
+  if(packetId)
+  {
+    packet += (char)(packetId >> 8);
+    packet += (char)packetId;
+  }
+  return packet + "21.50";
+}
+
+static std::string puback(uint16_t packetId)
+{
+  return std::string("\x40\x02", 2) + (char)(packetId >> 8) + (char)packetId;
+}
+
+/** Asserts that the client sent exactly the expected bytes. */
+static void assertSent(const std::string& expected)
+{
+  TEST_ASSERT_EQUAL_size_t(expected.size(), server->sent.size());
+  TEST_ASSERT_EQUAL_MEMORY(expected.data(), server->sent.data(), expected.size());
+}
+
+/** Connects the client and answers the CONNECT. */
+static void connectClient()
+{
+  TEST_ASSERT_TRUE(client->connect());
+  server->accept();
+  TEST_ASSERT_EQUAL_UINT8(MQTT_CTRL_CONNECT << 4, (uint8_t)server->sent[0]);
+  server->sent.clear();
+  server->ack();
+  server->receive(CONNACK);
+  TEST_ASSERT_TRUE(client->connected());
+}
+
+void setUp()
+{
+  simulatedMillis = 1000;
+  client = new Client("localhost", 1883, "test", "user", "key", KEEP_ALIVE);
+  server = AsyncClient::created;
+}
+
+void tearDown()
+{
+  delete client;
+}
+
+void test_connack_completes_the_connection()
+{
+  TEST_ASSERT_TRUE(client->connect());
+  TEST_ASSERT_EQUAL_UINT16(1, server->connects);
+  TEST_ASSERT_TRUE(client->getState() == Client::State::CONNECTING);
+
+  server->accept();
+  TEST_ASSERT_TRUE(client->getState() == Client::State::CONNECTING); // until the CONNACK
+  TEST_ASSERT_EQUAL_UINT8(MQTT_CTRL_CONNECT << 4, (uint8_t)server->sent[0]);
+  TEST_ASSERT_TRUE(server->sent.find("user") != std::string::npos);
+
+  server->receive(CONNACK.substr(0, 1)); // split across two segments
+  server->receive(CONNACK.substr(1));
+  TEST_ASSERT_TRUE(client->getState() == Client::State::CONNECTED);
+}
+
+void test_qos1_publish_is_queued_until_its_puback()
+{
+  connectClient();
+  TEST_ASSERT_TRUE(client->publish(TOPIC, PAYLOAD, 5, 0));
+  TEST_ASSERT_TRUE(client->publish(TOPIC, PAYLOAD, 5, 1));
+  assertSent(publishPacket(0) + publishPacket(1));
+  TEST_ASSERT_EQUAL_UINT8(1, client->queued()); // the QoS 0 publish is done once sent
+
+  server->receive(puback(1));
+  TEST_ASSERT_EQUAL_UINT8(0, client->queued());
+}
+
+void test_publish_waits_for_the_tcp_window()
+{
+  connectClient();
+  server->window = 10;
+  TEST_ASSERT_TRUE(client->publish(TOPIC, PAYLOAD, 5, 1));
+  TEST_ASSERT_EQUAL_size_t(10, server->sent.size());
+
+  while(server->unacked) server->ack();
+  assertSent(publishPacket(1));
+}
+
+void test_reconnect_resends_unacknowledged_publish_as_duplicate()
+{
+  connectClient();
+  TEST_ASSERT_TRUE(client->publish(TOPIC, PAYLOAD, 5, 1));
+  server->drop();
+  TEST_ASSERT_TRUE(client->getState() == Client::State::DISCONNECTED);
+  TEST_ASSERT_EQUAL_UINT8(1, client->queued());
+
+  connectClient(); // clears what was sent before the CONNACK
+  assertSent(publishPacket(1, true));
+  server->receive(puback(1));
+  TEST_ASSERT_EQUAL_UINT8(0, client->queued());
+}
+
+/** A partly received packet of a broken connection must not be continued by the next one. */
+void test_reconnect_discards_partly_received_packet()
+{
+  connectClient();
+  TEST_ASSERT_TRUE(client->publish(TOPIC, PAYLOAD, 5, 1));
+  server->receive(puback(1).substr(0, 2));
+  server->drop();
+
+  connectClient();
+  server->receive(puback(1));
+  TEST_ASSERT_EQUAL_UINT8(0, client->queued());
+}
+
+/** Regression: an abandoned connection attempt left the client CONNECTING forever, AsyncClient::close() has nothing to close yet. */
+void test_connect_timeout_abandons_the_attempt()
+{
+  TEST_ASSERT_TRUE(client->connect());
+  simulatedMillis += MQTT_ASYNC_CONNECT_TIMEOUT;
+  runTimers();
+  TEST_ASSERT_TRUE(client->getState() == Client::State::CONNECTING);
+
+  simulatedMillis += 1;
+  runTimers();
+  TEST_ASSERT_TRUE(client->getState() == Client::State::DISCONNECTED);
+
+  // the abandoned attempt succeeds late, the connection is closed again without a CONNECT
+  server->accept();
+  TEST_ASSERT_EQUAL_UINT16(1, server->closes);
+  TEST_ASSERT_TRUE(server->sent.empty());
+  TEST_ASSERT_TRUE(client->getState() == Client::State::DISCONNECTED);
+
+  connectClient();
+  TEST_ASSERT_EQUAL_UINT16(2, server->connects);
+}
+
+void test_refused_connection_can_be_retried()
+{
+  TEST_ASSERT_TRUE(client->connect());
+  server->refuse();
+  TEST_ASSERT_TRUE(client->getState() == Client::State::DISCONNECTED);
+  connectClient();
+}
+
+void test_missing_connack_closes_the_connection()
+{
+  TEST_ASSERT_TRUE(client->connect());
+  server->accept();
+  simulatedMillis += MQTT_ASYNC_CONNECT_TIMEOUT + 1;
+  runTimers();
+  TEST_ASSERT_EQUAL_UINT16(1, server->closes);
+  TEST_ASSERT_TRUE(client->getState() == Client::State::DISCONNECTED);
+}
+
+void test_keep_alive_pings_and_closes_without_pingresp()
+{
+  connectClient();
+  simulatedMillis += KEEP_ALIVE * 500UL;
+  runTimers();
+  assertSent(PINGREQ);
+
+  server->receive(PINGRESP);
+  server->sent.clear();
+  simulatedMillis += KEEP_ALIVE * 500UL;
+  runTimers();
+  assertSent(PINGREQ);
+
+  simulatedMillis += KEEP_ALIVE * 1000UL + 1;
+  runTimers();
+  TEST_ASSERT_EQUAL_UINT16(1, server->closes);
+  TEST_ASSERT_TRUE(client->getState() == Client::State::DISCONNECTED);
+}
+
+int main(int, char**)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_connack_completes_the_connection);
+  RUN_TEST(test_qos1_publish_is_queued_until_its_puback);
+  RUN_TEST(test_publish_waits_for_the_tcp_window);
+  RUN_TEST(test_reconnect_resends_unacknowledged_publish_as_duplicate);
+  RUN_TEST(test_reconnect_discards_partly_received_packet);
+  RUN_TEST(test_connect_timeout_abandons_the_attempt);
+  RUN_TEST(test_refused_connection_can_be_retried);
+  RUN_TEST(test_missing_connack_closes_the_connection);
+  RUN_TEST(test_keep_alive_pings_and_closes_without_pingresp);
+  return UNITY_END();
+}
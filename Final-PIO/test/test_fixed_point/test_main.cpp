@@ -0,0 +1,149 @@
+/**
+ * @file test_main.cpp
+ * @author Simon Schimik
+ * @version 3.0
+ *
+ * Host test and benchmark of the fixed point sample pipeline against the double pipeline it replaced.
+ *
+ * Per sample every field gets READINGS readings added to its window, the window is summarised and all values are formatted for publishing.
+ * The host has a double-precision FPU, the ESP32 emulates double in software, so on the device the gap is larger than measured here.
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <math.h>
+#include <string.h>
+#include "SensorSample.h"
+#include "WindowStats.h"
+
+static const uint8_t READINGS = 15; // BME280 readings per LOOPDELAY, see BME_INTERVAL
+static const uint32_t SAMPLES = 20000;
+
+static volatile uint32_t sink;
+
+/** Reading of a field in fixed point, a slowly varying signal with some noise. */
+static int32_t reading(uint8_t field, uint32_t sample, uint8_t index)
+{
+  static const int32_t base[Field::COUNT] = {2150, 4530, 98312, 123, 87, 812};
+  return base[field] + (int32_t)((sample * 7 + index * 13 + field) % 41) - 20;
+}
+
+/** Fixed point pipeline: WindowStats, formatFixed() and formatUnsigned(). */
+static void fixedSample(uint32_t sample)
+{
+  char value[16];
+  uint32_t length = 0;
+  for(uint8_t field = 0; field < Field::COUNT; field++)
+  {
+    WindowStats window;
+    for(uint8_t index = 0; index < READINGS; index++) window.add(reading(field, sample, index));
+    FieldSummary summary = window.summary();
+    Field::Id id = (Field::Id)field;
+    length += formatFixed(value, sizeof(value), id, summary.mean);
+    length += formatFixed(value, sizeof(value), id, summary.min);
+    length += formatFixed(value, sizeof(value), id, summary.max);
+    length += formatFixed(value, sizeof(value), id, summary.stddev);
+    length += formatUnsigned(value, sizeof(value), summary.count);
+  }
+  sink = length;
+}
+
+/** double pipeline the fixed point one replaced: values in unit, running sums in double and snprintf("%.*f"). */
+static void doubleSample(uint32_t sample)
+{
+  char value[16];
+  uint32_t length = 0;
+  for(uint8_t field = 0; field < Field::COUNT; field++)
+  {
+    double scale = fieldScale((Field::Id)field);
+    uint8_t precision = FIELDS[field].precision;
+    double sum = 0, sumSquares = 0, min = 0, max = 0;
+    for(uint8_t index = 0; index < READINGS; index++)
+    {
+      double v = reading(field, sample, index) / scale;
+      if(index == 0 || v < min) min = v;
+      if(index == 0 || v > max) max = v;
+      sum += v;
+      sumSquares += v * v;
+    }
+    double mean = sum / READINGS;
+    double variance = sumSquares / READINGS - mean * mean;
+    double stddev = variance > 0 ? sqrt(variance) : 0;
+    length += snprintf(value, sizeof(value), "%.*f", precision, mean);
+    length += snprintf(value, sizeof(value), "%.*f", precision, min);
+    length += snprintf(value, sizeof(value), "%.*f", precision, max);
+    length += snprintf(value, sizeof(value), "%.*f", precision, stddev);
+    length += snprintf(value, sizeof(value), "%u", READINGS);
+  }
+  sink = length;
+}
+
+/** @return mean time per sample in ns. */
+template<typename Function>
+static double nsPerSample(Function function)
+{
+  auto start = std::chrono::steady_clock::now();
+  for(uint32_t sample = 0; sample < SAMPLES; sample++) function(sample);
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / SAMPLES;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_format_fixed_matches_double()
+{
+  static const int32_t values[] = {0, 1, -1, 5, 99, 100, 2150, -2150, -5, 98312, 2147483647, -2147483647};
+  char fixed[16], reference[32];
+  for(const FieldDescriptor& field : FIELDS)
+  {
+    for(int32_t value : values)
+    {
+      formatFixed(fixed, sizeof(fixed), field.id, value);
+      snprintf(reference, sizeof(reference), "%.*f", field.precision, (double)value / fieldScale(field.id));
+      TEST_ASSERT_EQUAL_STRING(reference, fixed);
+    }
+  }
+}
+
+void test_window_summary_matches_double()
+{
+  for(uint8_t field = 0; field < Field::COUNT; field++)
+  {
+    WindowStats window;
+    double sum = 0, sumSquares = 0;
+    for(uint8_t index = 0; index < READINGS; index++)
+    {
+      int32_t value = reading(field, 1, index);
+      window.add(value);
+      sum += value;
+      sumSquares += (double)value * value;
+    }
+    FieldSummary summary = window.summary();
+    double mean = sum / READINGS;
+    TEST_ASSERT_EQUAL_INT32((int32_t)lround(mean), summary.mean);
+    TEST_ASSERT_LESS_OR_EQUAL(1, abs(summary.stddev - (int32_t)lround(sqrt(sumSquares / READINGS - mean * mean))));
+    TEST_ASSERT_EQUAL_UINT16(READINGS, summary.count);
+  }
+}
+
+void benchmark_fixed_against_double()
+{
+  nsPerSample(fixedSample); // warm up the caches
+  nsPerSample(doubleSample);
+  double fixed = nsPerSample(fixedSample);
+  double floating = nsPerSample(doubleSample);
+
+  char message[128];
+  snprintf(message, sizeof(message), "per sample: fixed point %.0f ns, double %.0f ns (%.1fx)", fixed, floating, floating / fixed);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_TRUE_MESSAGE(fixed < floating, "fixed point pipeline not faster than double");
+}
+
+int main(int, char**)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_format_fixed_matches_double);
+  RUN_TEST(test_window_summary_matches_double);
+  RUN_TEST(benchmark_fixed_against_double);
+  return UNITY_END();
+}
@@ -0,0 +1,169 @@
+/**
+ * @file test_main.cpp
+ * @author Simon Schimik
+ * @version 3.0
+ *
+ * Host test and benchmark of the HampelFilter over classroom traces.
+ *
+ * The traces follow a school day in a classroom: CO2 rises during a lesson and drops once the windows are opened in the break,
+ * PM follows the activity in the room. Known glitches (spikes, dropouts, saturated readings) are injected, the filter has to flag them
+ * without flagging the regular signal.
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <vector>
+#include "config.h"
+#include "SensorSample.h"
+#include "HampelFilter.h"
+
+struct Reading
+{
+  int32_t value;
+  bool glitch; ///< injected, the filter has to flag it
+};
+
+/** Deterministic noise in +-amplitude. */
+static int32_t noise(int32_t amplitude)
+{
+  static uint32_t state = 4711;
+  state = state * 1664525 + 1013904223;
+  return (int32_t)(state >> 8) % (amplitude + 1) * ((state & 1) ? 1 : -1);
+}
+
+/**
+ * CO2 in ppm, one reading every MH_INTERVAL ms over four lessons of 50 min, each followed by a 10 min break with the windows open.
+ */
+static std::vector<Reading> co2Trace()
+{
+  std::vector<Reading> trace;
+  const uint32_t perMinute = 60000 / MH_INTERVAL;
+  int32_t level = 450;
+  for(uint8_t lesson = 0; lesson < 4; lesson++)
+  {
+    for(uint32_t i = 0; i < 50 * perMinute; i++)
+    {
+      level += (i % 4 == 0) ? 1 : 0; // about 24 ppm per minute with 25 pupils
+      trace.push_back({level + noise(8), false});
+    }
+    for(uint32_t i = 0; i < 10 * perMinute; i++)
+    {
+      level -= (level - 450) / 40; // airing, decays towards the outside level
+      trace.push_back({level + noise(8), false});
+    }
+  }
+
+  for(size_t i = 300; i < trace.size(); i += 731) trace[i] = {trace[i].value + 2500, true}; // spikes
+  for(size_t i = 500; i < trace.size(); i += 997) trace[i] = {0, true};                      // dropouts
+  for(size_t i = 700; i < trace.size(); i += 1409) trace[i] = {5000, true};                  // saturated readings
+  return trace;
+}
+
+/**
+ * PM2.5 in 0.1 um_g/m^3, one reading per second (active reporting) over the same day. Chalk dust raises the level in steps when the board is wiped.
+ */
+static std::vector<Reading> pmTrace()
+{
+  std::vector<Reading> trace;
+  int32_t level = 80;
+  for(uint32_t second = 0; second < 4 * 3600; second++)
+  {
+    if(second % 1800 == 900) level += 60;                     // board wiped, the level rises and stays
+    if(second % 3600 == 3000) level = 80;                     // windows opened
+    trace.push_back({level + noise(level / 10), false});
+  }
+
+  for(size_t i = 200; i < trace.size(); i += 613) trace[i] = {trace[i].value * 8, true}; // a fly in the inlet
+  for(size_t i = 400; i < trace.size(); i += 1201) trace[i] = {9999, true};             // out of range reading
+  return trace;
+}
+
+struct Result
+{
+  uint32_t glitches = 0;
+  uint32_t flaggedGlitches = 0;
+  uint32_t regular = 0;
+  uint32_t flaggedRegular = 0;
+  double ns = 0; ///< mean time per reading
+};
+
+static Result run(const std::vector<Reading>& trace, Field::Id field)
+{
+  HampelFilter<OUTLIER_WINDOW> filter;
+  Result result;
+  auto start = std::chrono::steady_clock::now();
+  for(const Reading& reading : trace)
+  {
+    bool suspect = filter.isOutlier(reading.value, FIELDS[field].noiseFloor, OUTLIER_THRESHOLD);
+    if(reading.glitch)
+    {
+      result.glitches++;
+      result.flaggedGlitches += suspect;
+    }
+    else
+    {
+      result.regular++;
+      result.flaggedRegular += suspect;
+    }
+  }
+  result.ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / trace.size();
+  return result;
+}
+
+static void report(const char* name, const Result& result)
+{
+  char message[160];
+  snprintf(message, sizeof(message), "%s: %u/%u glitches flagged, %u/%u regular readings flagged, %.1f ns per reading",
+           name, result.flaggedGlitches, result.glitches, result.flaggedRegular, result.regular, result.ns);
+  TEST_MESSAGE(message);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_accepts_every_reading_until_the_window_is_full()
+{
+  HampelFilter<OUTLIER_WINDOW> filter;
+  static const int32_t readings[OUTLIER_WINDOW] = {400, 5000, 0, 420, 9999, 410, 405};
+  for(int32_t value : readings) TEST_ASSERT_FALSE(filter.isOutlier(value, 50, OUTLIER_THRESHOLD));
+}
+
+void test_flags_a_spike_and_accepts_a_step()
+{
+  HampelFilter<OUTLIER_WINDOW> filter;
+  for(uint8_t i = 0; i < OUTLIER_WINDOW; i++) filter.isOutlier(500, 50, OUTLIER_THRESHOLD);
+  TEST_ASSERT_TRUE(filter.isOutlier(2000, 50, OUTLIER_THRESHOLD));
+  TEST_ASSERT_FALSE(filter.isOutlier(500, 50, OUTLIER_THRESHOLD));
+
+  // a lasting step is accepted once it makes up half of the window
+  uint8_t flagged = 0;
+  for(uint8_t i = 0; i < OUTLIER_WINDOW; i++) flagged += filter.isOutlier(1500, 50, OUTLIER_THRESHOLD);
+  TEST_ASSERT_LESS_OR_EQUAL(OUTLIER_WINDOW / 2, flagged);
+  TEST_ASSERT_FALSE(filter.isOutlier(1500, 50, OUTLIER_THRESHOLD));
+}
+
+void benchmark_classroom_co2()
+{
+  Result result = run(co2Trace(), Field::CO2);
+  report("CO2", result);
+  TEST_ASSERT_EQUAL_UINT32(result.glitches, result.flaggedGlitches);
+  TEST_ASSERT_LESS_THAN(result.regular / 100, result.flaggedRegular); // under 1 % false alarms
+}
+
+void benchmark_classroom_pm25()
+{
+  Result result = run(pmTrace(), Field::PM25);
+  report("PM2.5", result);
+  TEST_ASSERT_EQUAL_UINT32(result.glitches, result.flaggedGlitches);
+  TEST_ASSERT_LESS_THAN(result.regular / 100, result.flaggedRegular);
+}
+
+int main(int, char**)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_accepts_every_reading_until_the_window_is_full);
+  RUN_TEST(test_flags_a_spike_and_accepts_a_step);
+  RUN_TEST(benchmark_classroom_co2);
+  RUN_TEST(benchmark_classroom_pm25);
+  return UNITY_END();
+}
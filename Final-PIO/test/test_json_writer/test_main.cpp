@@ -0,0 +1,151 @@
+/**
+ * @file test_main.cpp
+ * @author Simon Schimik
+ * @version 3.0
+ *
+ * Host test and micro-benchmark of the JsonWriter payload of the HTTPLogger.
+ *
+ * The reference builds the payload like HTTPLogger did before, by concatenating temporary strings (std::string instead of Arduino String)
+ * and cutting off the last character. Both payloads have to be byte-identical.
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <string>
+#include "JsonWriter.h"
+
+static const char MAC[] = "24:0A:C4:12:34:56";
+static const uint32_t SAMPLES = 50000;
+
+static volatile size_t sink;
+
+static SensorSample makeSample(uint32_t seed)
+{
+  SensorSample sample;
+  sample.timestamp = seed * 15000;
+  static const int32_t base[Field::COUNT] = {2150, 4530, 98312, 123, 87, 812};
+  for(uint8_t field = 0; field < Field::COUNT; field++)
+  {
+    int32_t value = base[field] + (int32_t)(seed * 37 % 101) - 50;
+    sample.values[field] = value;
+    sample.summary[field] = {value, value - 12, value + 9, 4, 15};
+  }
+  sample.suspect = seed % 3 ? 0 : 1 << Field::CO2;
+  sample.warming = seed % 5 ? 0 : 1 << Field::PM25 | 1 << Field::PM10;
+  return sample;
+}
+
+/** Payload as written by HTTPLogger::append(). */
+static size_t writePayload(char* buffer, size_t size, const SensorSample& sample, bool summary)
+{
+  JsonWriter json(buffer, size);
+  forEachPublishedValue(sample, summary, [&](const FieldDescriptor& field, Suffix::Id suffix, const char* value)
+  {
+    json.member(field.jsonKey, SUFFIXES[suffix], value);
+  });
+  json.member("mac", "", MAC);
+  json.end();
+  return json.getLength();
+}
+
+/** Payload as built by the String concatenation HTTPLogger::log() used before. */
+static std::string concatenatePayload(const SensorSample& sample, bool summary)
+{
+  std::string payload = "{";
+  forEachPublishedValue(sample, summary, [&](const FieldDescriptor& field, Suffix::Id suffix, const char* value)
+  {
+    payload += "\"" + std::string(field.jsonKey) + std::string(SUFFIXES[suffix]) + "\"" + ":\"" + std::string(value) + "\",";
+  });
+  payload += "\"mac\":\"" + std::string(MAC) + "\"}";
+  payload = payload.substr(0, payload.length() - 1);
+  payload += "}";
+  return payload;
+}
+
+/** @return mean time per payload in ns. */
+template<typename Function>
+static double nsPerPayload(Function function)
+{
+  auto start = std::chrono::steady_clock::now();
+  for(uint32_t seed = 0; seed < SAMPLES; seed++) function(seed);
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / SAMPLES;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_payload_matches_string_concatenation()
+{
+  char buffer[jsonObjectSize(jsonFieldsLength(true) + jsonMemberLength(constLength("mac"), 0, 17))];
+  for(uint32_t seed = 0; seed < 100; seed++)
+  {
+    SensorSample sample = makeSample(seed);
+    for(bool summary : {false, true})
+    {
+      size_t length = writePayload(buffer, sizeof(buffer), sample, summary);
+      std::string reference = concatenatePayload(sample, summary);
+      TEST_ASSERT_EQUAL_size_t(reference.length(), length);
+      TEST_ASSERT_EQUAL_STRING(reference.c_str(), buffer);
+    }
+  }
+}
+
+void test_buffer_size_holds_the_largest_payload()
+{
+  SensorSample sample;
+  for(uint8_t field = 0; field < Field::COUNT; field++)
+  {
+    sample.values[field] = INT32_MIN;
+    sample.summary[field] = {INT32_MIN, INT32_MIN, INT32_MIN, INT32_MIN, UINT16_MAX};
+  }
+  sample.suspect = sample.warming = (1 << Field::COUNT) - 1;
+
+  for(bool summary : {false, true})
+  {
+    char buffer[jsonObjectSize(jsonFieldsLength(true))];
+    JsonWriter json(buffer, jsonObjectSize(jsonFieldsLength(summary)));
+    forEachPublishedValue(sample, summary, [&](const FieldDescriptor& field, Suffix::Id suffix, const char* value)
+    {
+      json.member(field.jsonKey, SUFFIXES[suffix], value);
+    });
+    json.end();
+    TEST_ASSERT_FALSE(json.overflowed());
+  }
+}
+
+void test_overflow_truncates_and_terminates()
+{
+  char buffer[16];
+  JsonWriter json(buffer, sizeof(buffer));
+  json.member("temperature", "", "21.50");
+  json.end();
+  TEST_ASSERT_TRUE(json.overflowed());
+  TEST_ASSERT_EQUAL_size_t(sizeof(buffer) - 1, json.getLength());
+  TEST_ASSERT_EQUAL_size_t(sizeof(buffer) - 1, strlen(buffer));
+}
+
+void benchmark_json_writer_against_string_concatenation()
+{
+  for(bool summary : {false, true})
+  {
+    char buffer[jsonObjectSize(jsonFieldsLength(true) + jsonMemberLength(constLength("mac"), 0, 17))];
+    double writer = nsPerPayload([&](uint32_t seed) { sink = writePayload(buffer, sizeof(buffer), makeSample(seed), summary); });
+    double concatenation = nsPerPayload([&](uint32_t seed) { sink = concatenatePayload(makeSample(seed), summary).length(); });
+
+    char message[128];
+    snprintf(message, sizeof(message), "%s payload: JsonWriter %.0f ns, string concatenation %.0f ns (%.1fx)",
+             summary ? "summary" : "latest", writer, concatenation, concatenation / writer);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE_MESSAGE(writer < concatenation, "JsonWriter not faster than string concatenation");
+  }
+}
+
+int main(int, char**)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_payload_matches_string_concatenation);
+  RUN_TEST(test_buffer_size_holds_the_largest_payload);
+  RUN_TEST(test_overflow_truncates_and_terminates);
+  RUN_TEST(benchmark_json_writer_against_string_concatenation);
+  return UNITY_END();
+}
@@ -0,0 +1,48 @@
+/**
+ * @file Arduino.h
+ * @author Simon Schimik
+ * @version 3.0
+ *
+ * Host stand-in for the parts of the Arduino core Adafruit_MQTT uses, millis() is the simulated clock of the broker stand-in.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+#define HEX 16
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+
+typedef bool boolean;
+
+class __FlashStringHelper;
+#define F(text) (reinterpret_cast<const __FlashStringHelper*>(text))
+
+/** Simulated time in ms, advanced by the broker stand-in while the client waits. */
+inline uint32_t simulatedMillis = 0;
+
+inline unsigned long millis() { return simulatedMillis; }
+inline void delay(uint32_t ms) { simulatedMillis += ms; }
+
+inline char* ltoa(long value, char* buffer, int) { sprintf(buffer, "%ld", value); return buffer; }
+inline char* ultoa(unsigned long value, char* buffer, int) { sprintf(buffer, "%lu", value); return buffer; }
+inline char* dtostrf(double value, signed char width, unsigned char precision, char* buffer)
+{
+  sprintf(buffer, "%*.*f", width, precision, value);
+  return buffer;
+}
+
+/** Discards the debug and error output of the library. */
+struct SerialStub
+{
+  template<typename... Args> void print(Args...) {}
+  template<typename... Args> void println(Args...) {}
+  void write(uint8_t) {}
+};
+
+inline SerialStub Serial;
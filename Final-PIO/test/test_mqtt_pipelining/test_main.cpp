@@ -0,0 +1,243 @@
+/**
+ * @file test_main.cpp
+ * @author Simon Schimik
+ * @version 3.0
+ *
+ * Host test of the QoS 1 pipelining of Adafruit_MQTT against a local broker stand-in.
+ *
+ * The stand-in replaces the transport of Adafruit_MQTT: it decodes the packets the client sends and answers CONNECT with CONNACK,
+ * QoS 1 PUBLISH with PUBACK and PINGREQ with PINGRESP, every answer arrives one round trip later. The clock (millis()) is simulated,
+ * it only advances while the client waits for an answer, so the elapsed time counts the round trips exactly.
+ */
+
+#include <unity.h>
+#include <deque>
+#include <vector>
+#include "../../.pio/libdeps/esp32dev/Adafruit MQTT Library/Adafruit_MQTT.cpp"
+
+static const uint32_t RTT = 50; // ms
+static const uint8_t MESSAGES = 12;
+
+class LocalBroker : public Adafruit_MQTT
+{
+  private:
+    struct Answer
+    {
+      uint32_t due; ///< millis() when the answer arrives at the client
+      std::vector<uint8_t> bytes;
+    };
+
+    bool online = false;
+    std::vector<uint8_t> received; ///< bytes sent by the client, not yet decoded
+    std::deque<Answer> answers;
+
+    void answer(std::vector<uint8_t> bytes) { answers.push_back({simulatedMillis + RTT, bytes}); }
+
+    /** Decodes and answers every complete packet the client has sent. */
+    void decode()
+    {
+      while(received.size() >= 2)
+      {
+        uint32_t length = 0, multiplier = 1;
+        size_t header = 1;
+        do
+        {
+          if(header >= received.size()) return;
+          length += (received[header] & 0x7F) * multiplier;
+          multiplier *= 128;
+        }while(received[header++] & 0x80);
+        if(received.size() < header + length) return;
+
+        const uint8_t* body = &received[header];
+        switch(received[0] >> 4)
+        {
+          case MQTT_CTRL_CONNECT:
+            answer({MQTT_CTRL_CONNECTACK << 4, 2, 0, 0});
+            break;
+          case MQTT_CTRL_PUBLISH:
+            if((received[0] >> 1) & 0x3)
+            {
+              uint16_t topicLength = (body[0] << 8) | body[1];
+              uint16_t packetid = (body[2 + topicLength] << 8) | body[3 + topicLength];
+              publishes.push_back(packetid);
+              if(received[0] & 0x08) duplicates++;
+              if(pubacksToDrop > 0) pubacksToDrop--;
+              else answer({MQTT_CTRL_PUBACK << 4, 2, (uint8_t)(packetid >> 8), (uint8_t)packetid});
+            }
+            break;
+          case MQTT_CTRL_PINGREQ:
+            answer({MQTT_CTRL_PINGRESP << 4, 0});
+            break;
+        }
+        received.erase(received.begin(), received.begin() + header + length);
+      }
+    }
+
+  protected:
+    bool connectServer()
+    {
+      online = true;
+      return true;
+    }
+
+    bool disconnectServer()
+    {
+      online = false;
+      return true;
+    }
+
+    bool sendPacket(uint8_t* buffer, uint16_t len)
+    {
+      if(!online) return false;
+      received.insert(received.end(), buffer, buffer + len);
+      decode();
+      return true;
+    }
+
+    /** Returns the bytes of the answers that have arrived, waits (advances the clock) up to timeout for the rest. */
+    uint16_t readPacket(uint8_t* buffer, uint16_t maxlen, int16_t timeout)
+    {
+      uint32_t deadline = simulatedMillis + timeout;
+      uint16_t length = 0;
+      while(length < maxlen)
+      {
+        if(answers.empty() || answers.front().due > deadline)
+        {
+          simulatedMillis = deadline;
+          break;
+        }
+        if(answers.front().due > simulatedMillis) simulatedMillis = answers.front().due;
+
+        Answer& next = answers.front();
+        while(length < maxlen && !next.bytes.empty())
+        {
+          buffer[length++] = next.bytes.front();
+          next.bytes.erase(next.bytes.begin());
+        }
+        if(next.bytes.empty()) answers.pop_front();
+      }
+      return length;
+    }
+
+  public:
+    std::vector<uint16_t> publishes; ///< packet ids of all QoS 1 publishes received, retransmissions included
+    uint16_t duplicates = 0;         ///< publishes received with the DUP flag
+    uint8_t pubacksToDrop = 0;       ///< the next PUBACKs are lost
+
+    LocalBroker() : Adafruit_MQTT("localhost", 1883, "test", "", "") {}
+
+    bool connected() { return online; }
+
+    /** The connection breaks, answers on the way are lost. */
+    void breakConnection()
+    {
+      online = false;
+      answers.clear();
+      received.clear();
+    }
+};
+
+static LocalBroker* broker;
+static uint8_t payload[] = "21.50";
+
+void setUp()
+{
+  simulatedMillis = 1000;
+  broker = new LocalBroker();
+  TEST_ASSERT_EQUAL_INT(0, broker->connect());
+}
+
+void tearDown()
+{
+  delete broker;
+}
+
+void test_pipelined_batch_costs_one_round_trip_per_window()
+{
+  uint32_t start = millis();
+  for(uint8_t i = 0; i < MESSAGES; i++) TEST_ASSERT_TRUE(broker->publishPipelined("user/feeds/temperature", payload, 5));
+  TEST_ASSERT_TRUE(broker->flushPipelined(5000));
+
+  uint32_t roundTrips = (millis() - start) / RTT;
+  char message[96];
+  snprintf(message, sizeof(message), "%u messages, window %u: %u round trips", MESSAGES, MQTT_INFLIGHT_WINDOW, roundTrips);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_EQUAL_UINT32((MESSAGES + MQTT_INFLIGHT_WINDOW - 1) / MQTT_INFLIGHT_WINDOW, roundTrips);
+  TEST_ASSERT_EQUAL_UINT8(0, broker->inflight());
+
+  // every publish got its own packet id
+  TEST_ASSERT_EQUAL_size_t(MESSAGES, broker->publishes.size());
+  for(size_t i = 0; i < broker->publishes.size(); i++)
+  {
+    TEST_ASSERT_TRUE(broker->publishes[i] != 0);
+    for(size_t j = 0; j < i; j++) TEST_ASSERT_TRUE(broker->publishes[i] != broker->publishes[j]);
+  }
+}
+
+void test_blocking_publish_costs_one_round_trip_per_message()
+{
+  uint32_t start = millis();
+  for(uint8_t i = 0; i < MESSAGES; i++) TEST_ASSERT_TRUE(broker->publish("user/feeds/temperature", payload, 5, MQTT_QOS_1));
+
+  uint32_t roundTrips = (millis() - start) / RTT;
+  char message[96];
+  snprintf(message, sizeof(message), "%u messages, blocking publish(): %u round trips", MESSAGES, roundTrips);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_EQUAL_UINT32(MESSAGES, roundTrips);
+}
+
+void test_lost_puback_is_recovered_by_retransmission()
+{
+  broker->pubacksToDrop = 1;
+  for(uint8_t i = 0; i < 3; i++) TEST_ASSERT_TRUE(broker->publishPipelined("user/feeds/temperature", payload, 5));
+
+  uint32_t start = millis();
+  TEST_ASSERT_TRUE(broker->flushPipelined(5000));
+  TEST_ASSERT_EQUAL_UINT8(0, broker->inflight());
+  TEST_ASSERT_EQUAL_UINT16(1, broker->duplicates);
+  TEST_ASSERT_EQUAL_size_t(4, broker->publishes.size());
+  TEST_ASSERT_EQUAL_UINT16(broker->publishes[0], broker->publishes[3]); // the first publish was sent again
+  TEST_ASSERT_GREATER_OR_EQUAL(MQTT_RETRANSMIT_MS, millis() - start);
+}
+
+void test_flush_times_out_while_pubacks_are_missing()
+{
+  broker->pubacksToDrop = 255;
+  TEST_ASSERT_TRUE(broker->publishPipelined("user/feeds/temperature", payload, 5));
+  TEST_ASSERT_FALSE(broker->flushPipelined(1000));
+  TEST_ASSERT_EQUAL_UINT8(1, broker->inflight()); // kept for the next flush
+}
+
+void test_reconnect_resends_publishes_in_flight()
+{
+  for(uint8_t i = 0; i < 2; i++) TEST_ASSERT_TRUE(broker->publishPipelined("user/feeds/temperature", payload, 5));
+  broker->breakConnection();
+  TEST_ASSERT_FALSE(broker->flushPipelined(1000));
+  TEST_ASSERT_EQUAL_UINT8(2, broker->inflight());
+
+  TEST_ASSERT_EQUAL_INT(0, broker->connect());
+  TEST_ASSERT_TRUE(broker->flushPipelined(1000));
+  TEST_ASSERT_EQUAL_UINT8(0, broker->inflight());
+  TEST_ASSERT_EQUAL_UINT16(2, broker->duplicates);
+}
+
+void test_full_window_fails_without_pubacks()
+{
+  broker->pubacksToDrop = 255;
+  for(uint8_t i = 0; i < MQTT_INFLIGHT_WINDOW; i++) TEST_ASSERT_TRUE(broker->publishPipelined("user/feeds/temperature", payload, 5));
+  uint32_t start = millis();
+  TEST_ASSERT_FALSE(broker->publishPipelined("user/feeds/temperature", payload, 5));
+  TEST_ASSERT_EQUAL_UINT32(PUBLISH_TIMEOUT_MS, millis() - start);
+}
+
+int main(int, char**)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_pipelined_batch_costs_one_round_trip_per_window);
+  RUN_TEST(test_blocking_publish_costs_one_round_trip_per_message);
+  RUN_TEST(test_lost_puback_is_recovered_by_retransmission);
+  RUN_TEST(test_flush_times_out_while_pubacks_are_missing);
+  RUN_TEST(test_reconnect_resends_publishes_in_flight);
+  RUN_TEST(test_full_window_fails_without_pubacks);
+  return UNITY_END();
+}
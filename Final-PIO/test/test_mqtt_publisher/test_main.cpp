@@ -0,0 +1,171 @@
+/**
+ * @file test_main.cpp
+ * @author Simon Schimik
+ * @version 3.0
+ *
+ * Host test of the MQTTPublisher: the topics are built once by the constructor, publishing a sample must not allocate any memory.
+ *
+ * Allocations are counted by replacing the global operator new and, with glibc, malloc() (the publish path used malloc() for topics and values before).
+ */
+
+#include <unity.h>
+#include <new>
+#include <stdlib.h>
+#include <vector>
+#include "MQTTPublisher.h"
+
+static size_t allocations = 0;
+
+void* operator new(size_t size)
+{
+  allocations++;
+  void* memory = malloc(size ? size : 1);
+  if(!memory) throw std::bad_alloc();
+  return memory;
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* memory) noexcept { free(memory); }
+void operator delete[](void* memory) noexcept { free(memory); }
+void operator delete(void* memory, size_t) noexcept { free(memory); }
+void operator delete[](void* memory, size_t) noexcept { free(memory); }
+
+#ifdef __GLIBC__
+extern "C" void* __libc_malloc(size_t size);
+
+extern "C" void* malloc(size_t size)
+{
+  allocations++;
+  return __libc_malloc(size);
+}
+#endif
+
+/** Publisher recording the packets into fixed buffers instead of sending them. */
+class RecordingPublisher : public MQTTPublisher
+{
+  public:
+    static const uint8_t MAX_PACKETS = publishedValuesMax(true);
+
+    char packetTopics[MAX_PACKETS][64];
+    uint8_t packetPayloads[MAX_PACKETS][PAYLOAD_SIZE];
+    uint16_t packetLengths[MAX_PACKETS];
+    uint8_t packets = 0;
+
+    void publish(const char* topic, uint8_t* payload, uint16_t length)
+    {
+      if(packets == MAX_PACKETS) return;
+      strncpy(packetTopics[packets], topic, sizeof(packetTopics[packets]) - 1);
+      packetTopics[packets][sizeof(packetTopics[packets]) - 1] = '\0';
+      memcpy(packetPayloads[packets], payload, length);
+      packetLengths[packets] = length;
+      packets++;
+    }
+
+    using MQTTPublisher::publishFeeds;
+    using MQTTPublisher::publishJson;
+    using MQTTPublisher::publishBinary;
+    using MQTTPublisher::publishSample;
+    using MQTTPublisher::samplePackets;
+
+    void log(const SensorSample& sample) { publishSample(sample); }
+};
+
+static SensorSample makeSample()
+{
+  SensorSample sample;
+  sample.timestamp = 15000;
+  static const int32_t values[Field::COUNT] = {2150, 4530, 98312, 123, 87, 812};
+  for(uint8_t field = 0; field < Field::COUNT; field++)
+  {
+    sample.values[field] = values[field];
+    sample.summary[field] = {values[field], values[field] - 12, values[field] + 9, 4, 15};
+  }
+  sample.suspect = 1 << Field::CO2;
+  return sample;
+}
+
+static RecordingPublisher* publisher = new RecordingPublisher(); // constructed before counting
+
+void setUp()
+{
+  publisher->packets = 0;
+  allocations = 0;
+}
+
+void tearDown() {}
+
+void test_feed_topics_and_values()
+{
+  SensorSample sample = makeSample();
+  publisher->publishFeeds(sample);
+  TEST_ASSERT_EQUAL_UINT8(Field::COUNT + 1, publisher->packets); // every field plus CO2-suspect
+  TEST_ASSERT_EQUAL_STRING(AIOUSERNAME "/feeds/temperature", publisher->packetTopics[0]);
+  TEST_ASSERT_EQUAL_STRING(AIOUSERNAME "/feeds/CO2-suspect", publisher->packetTopics[Field::COUNT]);
+  TEST_ASSERT_EQUAL_UINT16(5, publisher->packetLengths[0]);
+  TEST_ASSERT_EQUAL_MEMORY("21.50", publisher->packetPayloads[0], 5);
+}
+
+void test_publish_feeds_does_not_allocate()
+{
+  SensorSample sample = makeSample();
+  for(uint16_t i = 0; i < 100; i++)
+  {
+    publisher->packets = 0;
+    publisher->publishFeeds(sample);
+  }
+  TEST_ASSERT_EQUAL_size_t(0, allocations);
+}
+
+void test_publish_json_does_not_allocate()
+{
+  SensorSample sample = makeSample();
+  for(uint16_t i = 0; i < 100; i++)
+  {
+    publisher->packets = 0;
+    publisher->publishJson(sample);
+  }
+  TEST_ASSERT_EQUAL_size_t(0, allocations);
+  TEST_ASSERT_EQUAL_STRING(AIOUSERNAME "/groups/" MQTT_GROUP "/json", publisher->packetTopics[0]);
+}
+
+void test_publish_binary_does_not_allocate()
+{
+  SensorSample sample = makeSample();
+  for(uint16_t i = 0; i < 100; i++)
+  {
+    publisher->packets = 0;
+    publisher->publishBinary(sample);
+  }
+  TEST_ASSERT_EQUAL_size_t(0, allocations);
+  TEST_ASSERT_EQUAL_UINT16(LOG_SUMMARY ? 116 : 32, publisher->packetLengths[0]);
+}
+
+void test_publish_sample_does_not_allocate()
+{
+  SensorSample sample = makeSample();
+  publisher->log(sample);
+  TEST_ASSERT_EQUAL_UINT8(publisher->samplePackets(sample), publisher->packets);
+  TEST_ASSERT_EQUAL_size_t(0, allocations);
+}
+
+/** Makes sure the counter sees allocations at all, otherwise the tests above prove nothing. */
+void test_allocations_are_counted()
+{
+  std::vector<int>* vector = new std::vector<int>(4);
+  void* memory = malloc(16);
+  free(memory);
+  delete vector;
+  TEST_ASSERT_GREATER_OR_EQUAL(2, allocations);
+}
+
+int main(int, char**)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_allocations_are_counted);
+  RUN_TEST(test_feed_topics_and_values);
+  RUN_TEST(test_publish_feeds_does_not_allocate);
+  RUN_TEST(test_publish_json_does_not_allocate);
+  RUN_TEST(test_publish_binary_does_not_allocate);
+  RUN_TEST(test_publish_sample_does_not_allocate);
+  return UNITY_END();
+}
@@ -0,0 +1,132 @@
+/**
+ * @file test_main.cpp
+ * @author Simon Schimik
+ * @version 3.0
+ *
+ * Host test of the SampleQueue, the acquisition task is run as pthread by the stand-in of Task.h.
+ */
+
+#include <unity.h>
+#include <atomic>
+#include "Task.h"
+#include "SampleQueue.h"
+
+static const uint32_t SAMPLES = 200000;
+
+/** Fills every value of a sample from its timestamp, so a torn read shows up as mismatch. */
+static SensorSample makeSample(uint32_t timestamp)
+{
+  SensorSample sample;
+  sample.timestamp = timestamp;
+  for(uint8_t field = 0; field < Field::COUNT; field++) sample.values[field] = timestamp * (field + 1);
+  return sample;
+}
+
+static bool isConsistent(const SensorSample& sample)
+{
+  for(uint8_t field = 0; field < Field::COUNT; field++)
+  {
+    if(sample.values[field] != (int32_t)(sample.timestamp * (field + 1))) return false;
+  }
+  return true;
+}
+
+struct Producer
+{
+  SampleQueue* queue;
+  std::atomic<bool> done{false};
+};
+
+/** Acquisition stand-in, pushes SAMPLES samples as fast as it can, samples that don't fit are dropped. */
+static void produce(void* arg)
+{
+  Producer* producer = static_cast<Producer*>(arg);
+  for(uint32_t timestamp = 1; timestamp <= SAMPLES; timestamp++) producer->queue->push(makeSample(timestamp));
+  producer->done.store(true);
+  endTask();
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_push_pop_in_order()
+{
+  SampleQueue queue(4);
+  SensorSample sample;
+  TEST_ASSERT_FALSE(queue.pop(sample));
+
+  for(uint32_t timestamp = 1; timestamp <= 3; timestamp++) TEST_ASSERT_TRUE(queue.push(makeSample(timestamp)));
+  for(uint32_t timestamp = 1; timestamp <= 3; timestamp++)
+  {
+    TEST_ASSERT_TRUE(queue.pop(sample));
+    TEST_ASSERT_EQUAL_UINT32(timestamp, sample.timestamp);
+  }
+  TEST_ASSERT_FALSE(queue.pop(sample));
+}
+
+void test_full_queue_drops_new_samples()
+{
+  SampleQueue queue(2);
+  TEST_ASSERT_TRUE(queue.push(makeSample(1)));
+  TEST_ASSERT_TRUE(queue.push(makeSample(2)));
+  TEST_ASSERT_FALSE(queue.push(makeSample(3)));
+  TEST_ASSERT_EQUAL_UINT32(1, queue.droppedCount());
+
+  SensorSample sample;
+  TEST_ASSERT_TRUE(queue.pop(sample));
+  TEST_ASSERT_EQUAL_UINT32(1, sample.timestamp); // the queued samples are kept, the new one is dropped
+}
+
+void test_pop_latest_skips_to_newest()
+{
+  SampleQueue queue(8);
+  SensorSample sample;
+  TEST_ASSERT_FALSE(queue.popLatest(sample));
+
+  for(uint32_t timestamp = 1; timestamp <= 5; timestamp++) queue.push(makeSample(timestamp));
+  TEST_ASSERT_TRUE(queue.popLatest(sample));
+  TEST_ASSERT_EQUAL_UINT32(5, sample.timestamp);
+  TEST_ASSERT_FALSE(queue.pop(sample));
+}
+
+/**
+ * Producer and consumer on different threads: every sample arrives once, in order and intact, or is counted as dropped.
+ */
+void test_concurrent_producer_and_consumer()
+{
+  SampleQueue queue(16);
+  Producer producer;
+  producer.queue = &queue;
+  TEST_ASSERT_TRUE(startTask(produce, "acquisition", 4096, &producer, 2, 1));
+
+  uint32_t received = 0, last = 0;
+  bool ordered = true, consistent = true;
+  SensorSample sample;
+  while(true)
+  {
+    bool finished = producer.done.load(); // checked before popping, so nothing pushed before is missed
+    while(queue.pop(sample))
+    {
+      ordered &= sample.timestamp > last;
+      consistent &= isConsistent(sample);
+      last = sample.timestamp;
+      received++;
+    }
+    if(finished) break;
+  }
+
+  TEST_ASSERT_TRUE(ordered);
+  TEST_ASSERT_TRUE(consistent);
+  TEST_ASSERT_EQUAL_UINT32(SAMPLES, received + queue.droppedCount());
+  TEST_ASSERT_GREATER_THAN(0, received);
+}
+
+int main(int, char**)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_push_pop_in_order);
+  RUN_TEST(test_full_queue_drops_new_samples);
+  RUN_TEST(test_pop_latest_skips_to_newest);
+  RUN_TEST(test_concurrent_producer_and_consumer);
+  return UNITY_END();
+}
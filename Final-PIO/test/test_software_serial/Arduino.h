@@ -0,0 +1,65 @@
+/**
+ * @file Arduino.h
+ * @author Simon Schimik
+ * @version 3.0
+ *
+ * Host stand-in for the parts of the Arduino core SoftwareSerial uses, cycle counter and RX level are driven by the edge replay.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <algorithm>
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define LOW 0x0
+#define HIGH 0x1
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define xt_rsil(a) (a)
+#define xt_wsr_ps(a)
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define digitalPinToInterrupt(pin) (pin)
+
+using std::min;
+
+/** Replayed line state: CPU cycle counter and RX level, the interrupt handler attached to the RX pin. */
+struct Replay
+{
+  uint32_t cycle = 0;
+  bool level = true;
+  void (*handler)(void*) = nullptr;
+  void* arg = nullptr;
+};
+
+inline Replay replay;
+
+struct EspClass
+{
+  uint32_t getCpuFreqMHz() { return 240; }
+  uint32_t getCycleCount() { return replay.cycle; }
+};
+
+inline EspClass ESP;
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return replay.level; }
+inline void attachInterruptArg(uint8_t, void (*handler)(void*), void* arg, int)
+{
+  replay.handler = handler;
+  replay.arg = arg;
+}
+inline void detachInterrupt(uint8_t) { replay.handler = nullptr; }
+inline unsigned long millis() { return replay.cycle / 240000; }
+inline void delay(uint32_t) {}
+inline void optimistic_yield(uint32_t) {}
@@ -0,0 +1,52 @@
+/**
+ * @file Stream.h
+ * @author Simon Schimik
+ * @version 3.0
+ *
+ * Host stand-in for the Stream interface of the Arduino core.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+class Print
+{
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size)
+    {
+      size_t n = 0;
+      while(size-- && write(*buffer++)) n++;
+      return n;
+    }
+    size_t write(const char* text)
+    {
+      size_t n = 0;
+      while(*text) n += write((uint8_t)*text++);
+      return n;
+    }
+    virtual void flush() {}
+};
+
+class Stream : public Print
+{
+  protected:
+    unsigned long _timeout = 1000;
+
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual size_t readBytes(char* buffer, size_t length) { return readBytes((uint8_t*)buffer, length); }
+    virtual size_t readBytes(uint8_t* buffer, size_t length)
+    {
+      size_t count = 0;
+      int c;
+      while(count < length && (c = read()) >= 0) buffer[count++] = c;
+      return count;
+    }
+    void setTimeout(unsigned long timeout) { _timeout = timeout; }
+};
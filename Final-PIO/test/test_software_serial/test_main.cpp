@@ -0,0 +1,206 @@
+/**
+ * @file test_main.cpp
+ * @author Simon Schimik
+ * @version 3.0
+ *
+ * Edge-replay test and benchmark of the SoftwareSerial receive path at 9600 baud.
+ *
+ * SDS011 frames are turned into RX edges with the timing of the wire at 240 MHz plus jitter. Every edge is replayed through the attached
+ * rxBitISR(), the frame is then decoded by available(), which drains the ISR buffer by pop_n() and decodes every complete word with
+ * rxWord() in one step, the edges of a word still being received with rxBits(isrCycle).
+ * The decoded bytes are compared with the frames, throughput and the worst-case time of a drain are reported.
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <vector>
+#define SWSERIAL_RX_STATS 1 // the edge count is checked against rxStats()
+#include "SoftwareSerial.cpp"
+
+static const uint32_t CPU_HZ = 240000000;
+static const uint32_t BAUD = 9600;
+static const uint32_t BIT_CYCLES = (CPU_HZ + BAUD / 2) / BAUD;
+static const uint8_t FRAME_SIZE = 10;
+static const uint32_t FRAMES = 2000;
+
+struct Edge
+{
+  uint32_t cycle;
+  bool level; ///< line level after the edge
+};
+
+/** Deterministic jitter of an edge in cycles, up to +-1/8 bit. */
+static int32_t jitter()
+{
+  static uint32_t state = 12345;
+  state = state * 1664525 + 1013904223;
+  return (int32_t)(state >> 16) % (int32_t)(BIT_CYCLES / 8);
+}
+
+/** SDS011 data frame as sent in active reporting mode: head, command, PM2.5, PM10, id, checksum, tail. */
+static void makeFrame(uint8_t frame[FRAME_SIZE], uint32_t index)
+{
+  uint16_t pm25 = 50 + index % 700, pm10 = 80 + index % 900;
+  frame[0] = 0xAA;
+  frame[1] = 0xC0;
+  frame[2] = pm25 & 0xFF;
+  frame[3] = pm25 >> 8;
+  frame[4] = pm10 & 0xFF;
+  frame[5] = pm10 >> 8;
+  frame[6] = 0x12;
+  frame[7] = 0x34;
+  frame[8] = 0;
+  for(uint8_t i = 2; i < 8; i++) frame[8] += frame[i];
+  frame[9] = 0xAB;
+}
+
+/**
+ * Edges of the words of a frame with the line idle high, starting at the given cycle.
+ * Each word is a start bit (low), 8 data bits LSB first, the even parity bit if parity is set and a stop bit (high).
+ *
+ * @return cycle after the last stop bit.
+ */
+static uint32_t frameEdges(const uint8_t* frame, uint8_t size, uint32_t start, bool parity, std::vector<Edge>& edges)
+{
+  uint32_t bit = 0;
+  bool level = true;
+  for(uint8_t i = 0; i < size; i++)
+  {
+    uint16_t bits = frame[i] << 1;
+    uint8_t count = 9;
+    if(parity) bits |= SoftwareSerial::parityEven(frame[i]) << count++;
+    bits |= 1 << count++;
+    for(uint8_t b = 0; b < count; b++, bit++)
+    {
+      bool next = bits & (1 << b);
+      if(next == level) continue;
+      level = next;
+      edges.push_back({start + bit * BIT_CYCLES + jitter(), level});
+    }
+  }
+  return start + bit * BIT_CYCLES;
+}
+
+/** Replays an edge: sets cycle counter and line level and calls the interrupt handler on the RX pin. */
+static void replayEdge(const Edge& edge)
+{
+  replay.cycle = edge.cycle;
+  replay.level = edge.level;
+  if(replay.handler) replay.handler(replay.arg);
+}
+
+/** @return true if the serial has exactly the bytes of the frame available. */
+static bool receivedFrame(SoftwareSerial& serial, const uint8_t* frame, uint8_t size)
+{
+  uint8_t received[16];
+  return serial.available() == size && serial.read(received, size) == size && memcmp(frame, received, size) == 0;
+}
+
+void setUp()
+{
+  replay.cycle = 1000;
+}
+
+void tearDown() {}
+
+/** Drains while the frame is received, so words are cut by a drain and have to be resumed edge by edge. */
+void test_words_split_across_drains()
+{
+  SoftwareSerial serial(25, 26);
+  serial.begin(BAUD, SWSERIAL_8N1);
+
+  uint8_t frame[FRAME_SIZE];
+  uint32_t start = 2 * BIT_CYCLES;
+  bool intact = true;
+  for(uint32_t index = 0; index < 200; index++)
+  {
+    std::vector<Edge> edges;
+    makeFrame(frame, index);
+    uint32_t end = frameEdges(frame, FRAME_SIZE, start, false, edges);
+    uint8_t drainEvery = 1 + index % 13;
+    for(size_t i = 0; i < edges.size(); i++)
+    {
+      replayEdge(edges[i]);
+      if(i % drainEvery) continue;
+      // drain halfway to the next edge
+      replay.cycle = i + 1 < edges.size() ? edges[i].cycle + (edges[i + 1].cycle - edges[i].cycle) / 2 : edges[i].cycle + BIT_CYCLES / 2;
+      serial.available();
+    }
+    start = end + BIT_CYCLES * 3;
+    replay.cycle = start;
+    intact &= receivedFrame(serial, frame, FRAME_SIZE);
+  }
+  TEST_ASSERT_TRUE(intact);
+}
+
+/** Parity bits are decoded along with the data bits. */
+void test_even_parity()
+{
+  SoftwareSerial serial(25, 26);
+  serial.begin(BAUD, SWSERIAL_8E1);
+
+  uint8_t frame[FRAME_SIZE];
+  makeFrame(frame, 42);
+  std::vector<Edge> edges;
+  uint32_t end = frameEdges(frame, FRAME_SIZE, 2 * BIT_CYCLES, true, edges);
+  for(const Edge& edge : edges) replayEdge(edge);
+  replay.cycle = end + BIT_CYCLES * 3;
+
+  TEST_ASSERT_EQUAL_INT(FRAME_SIZE, serial.available());
+  for(uint8_t i = 0; i < FRAME_SIZE; i++)
+  {
+    TEST_ASSERT_EQUAL_INT(frame[i], serial.read());
+    TEST_ASSERT_EQUAL(SoftwareSerial::parityEven(frame[i]), serial.readParity());
+  }
+}
+
+void benchmark_sds011_edge_replay()
+{
+  SoftwareSerial serial(25, 26);
+  serial.begin(BAUD, SWSERIAL_8N1);
+  TEST_ASSERT_NOT_NULL(replay.handler);
+
+  uint8_t frame[FRAME_SIZE];
+  uint32_t start = 2 * BIT_CYCLES;
+  uint64_t edges = 0, bytes = 0;
+  double decodeNs = 0, worstNs = 0;
+  bool intact = true;
+  std::vector<Edge> edgeList;
+
+  for(uint32_t index = 0; index < FRAMES; index++)
+  {
+    makeFrame(frame, index);
+    edgeList.clear();
+    uint32_t end = frameEdges(frame, FRAME_SIZE, start, false, edgeList);
+    for(const Edge& edge : edgeList) replayEdge(edge);
+    edges += edgeList.size();
+    start = end + BIT_CYCLES * 3; // pause of three bits, at most a stop bit may be pending
+    replay.cycle = start;
+
+    auto begin = std::chrono::steady_clock::now();
+    int available = serial.available();
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+    decodeNs += ns;
+    if(ns > worstNs) worstNs = ns;
+
+    intact &= available == FRAME_SIZE && receivedFrame(serial, frame, FRAME_SIZE);
+    bytes += FRAME_SIZE;
+  }
+
+  char message[160];
+  snprintf(message, sizeof(message), "%llu edges, %llu bytes: %.1f ns per byte, %.1f ns per edge, worst frame drain %.0f ns",
+           (unsigned long long)edges, (unsigned long long)bytes, decodeNs / bytes, decodeNs / edges, worstNs);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_TRUE(intact);
+  TEST_ASSERT_FALSE(serial.overflow());
+  TEST_ASSERT_EQUAL_UINT32(edges, serial.rxStats().isrCount);
+}
+
+int main(int, char**)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_words_split_across_drains);
+  RUN_TEST(test_even_parity);
+  RUN_TEST(benchmark_sds011_edge_replay);
+  return UNITY_END();
+}